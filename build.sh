@@ -5,4 +5,4 @@ for filename in ./src/*.cpp ./types/src/*.cpp; do
   source_files+=( "$filename" )
 done
 
-g++ -g -I ./include -I ./types/include -std=c++2a main.cpp "${source_files[@]}" -fconcepts -o matlang
+g++ -g -I ./include -I ./types/include -std=c++2a main.cpp "${source_files[@]}" -fconcepts -pthread -o matlang
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "object.h"
+#include "comm.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifndef MATLANG_BYTECODE_H
+#define MATLANG_BYTECODE_H
+
+
+namespace bc {
+    enum op_code : uint8_t {
+        LoadConst,   // dst = constants[operand]
+        LoadVar,     // dst = variables[operand]
+        Call,        // dst = commands[operand](args...)
+        MakeMatrix,  // dst = matrix of operand lines filled by args line by line
+        Store,       // variables[operand] = args[0]
+    };
+}
+
+struct Instruction {
+    bc::op_code op;
+    uint32_t dst;
+    uint32_t operand;
+    uint32_t args_begin; // arguments are registers Program::args[args_begin, args_begin + args_count)
+    uint32_t args_count;
+    uint32_t statement;  // index of source statement which instruction belongs to
+};
+
+// statements are ordered only by their dependencies, so independent ones may run concurrently
+struct Statement {
+    uint32_t code_begin, code_end;      // instructions Program::code[code_begin, code_end)
+    std::vector<uint32_t> dependencies; // statements which must be done before this one starts
+    std::vector<uint32_t> shared;       // registers read by other statements, they are materialized when it is done
+};
+
+// compiled script: it is never changed by execution, so it can be run any number of times
+struct Program {
+    std::vector<Instruction> code;
+    std::vector<uint32_t> args;
+    std::vector<sptrObj> constants;
+    std::vector<uint32_t> variables;                      // symbol ids of variable slots
+    std::vector<uint32_t> parameters;                     // slots which are read before the program sets them
+    std::vector<uint32_t> command_ids;                    // symbol ids of commands
+    std::vector<std::shared_ptr<BaseCommand>> commands;   // nullptr if command is unknown (error on call)
+    std::vector<Statement> statements;                    // in source order
+    size_t registers_count = 0;
+};
+
+#endif //MATLANG_BYTECODE_H
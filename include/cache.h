@@ -0,0 +1,74 @@
+#pragma once
+
+#include "object.h"
+#include "rational.h"
+#include "matrix.h"
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifndef MATLANG_CACHE_H
+#define MATLANG_CACHE_H
+
+
+// LRU cache of results of expensive commands keyed by (command tag, matrix content);
+// lookup hashes matrix and compares it with stored copy, that is O(n^2) against O(n^3) of the command itself
+class ResultCache {
+private:
+    struct Entry {
+        uint64_t hash;
+        uint32_t command;
+        size_t lines, columns;
+        std::vector<std::pair<int64_t, int64_t>> key; // numerators and denominators line by line
+        sptrObj result;
+        size_t bytes;
+    };
+
+    std::list<Entry> entries_; // most recently used first
+    std::unordered_multimap<uint64_t, std::list<Entry>::iterator> index_;
+    size_t bytes_ = 0, limit_ = 64 << 20;
+    size_t hits_ = 0, misses_ = 0;
+    mutable std::mutex mutex_;
+
+    ResultCache() = default;
+
+    static uint64_t Hash(uint32_t, const Matrix &);
+
+    static bool IsEqual(const Entry &, uint32_t, const Matrix &);
+
+    void Add(Entry &&); // expects locked mutex
+
+    void EvictTill(size_t); // expects locked mutex
+
+public:
+    ResultCache(const ResultCache &) = delete;
+
+    ResultCache &operator=(const ResultCache &) = delete;
+
+    static ResultCache &Instance();
+
+    sptrObj Find(uint32_t, const Matrix &); // nullptr if there is no such result
+
+    void Insert(uint32_t, const Matrix &, sptrObj); // result must be Rational or Matrix of rationals
+
+    void SetLimit(size_t); // in bytes, least recently used results are dropped to fit
+
+    void Clear();
+
+    [[nodiscard]] size_t Hits() const;
+
+    [[nodiscard]] size_t Misses() const;
+
+    [[nodiscard]] size_t Bytes() const;
+
+    void Save(const std::string &) const;
+
+    void Load(const std::string &); // loaded results are added to current ones
+};
+
+#endif //MATLANG_CACHE_H
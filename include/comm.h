@@ -3,9 +3,13 @@
 #include "object.h"
 #include "rational.h"
 #include "matrix.h"
+#include "lazy_matrix.h"
+#include "polynomial.h"
 #include "expression.h"
 
+#include <array>
 #include <functional>
+#include <initializer_list>
 #include <map>
 #include <memory>
 #include <stack>
@@ -17,7 +21,12 @@ namespace cmd {
         Print,
         Transpose,
         MatrixLinearTransform,
-        Arithmetic
+        CharacteristicPolynomial,
+        PolynomialEvaluation,
+        Arithmetic,
+        Load,
+        Save,
+        Workspace
 //        Initialize, // already done separately
     };
 
@@ -29,9 +38,25 @@ namespace cmd {
         det = 0b0110,
         rank = 0b0000,
     };
+
+    enum PivotMode {
+        first_nonzero,  // first nonzero value in the column
+        min_bitsize,    // value of the column with the shortest numerator and denominator
+        complete,       // same as min_bitsize, but searched in the whole remaining block with column swaps (rank only)
+    };
 }
 
 
+class Dispatcher;
+
+
+// rough shape of value and count of operations on rationals to compute it, it tells what is worth a task
+struct CostEstimate {
+    size_t lines = 0, columns = 0; // zero for scalar or unknown
+    double cost = 0;
+};
+
+
 class BaseCommand {
 private:
     cmd::cmd_type type_;
@@ -39,47 +64,172 @@ private:
 public:
     BaseCommand(cmd::cmd_type type) : type_(type) {}
 
-    virtual sptrObj Run(std::list<sptrObj> &) = 0;
+    [[nodiscard]] cmd::cmd_type GetType() const {
+        return type_;
+    }
+
+    virtual sptrObj Run(std::vector<sptrObj> &) = 0;
+
+    // pure command result depends only on its arguments, so it can be computed before execution
+    [[nodiscard]] virtual bool IsPure() const {
+        return true;
+    }
+
+    // estimate of result by estimates of arguments
+    [[nodiscard]] virtual CostEstimate Estimate(const std::vector<CostEstimate> &) const {
+        return {0, 0, 1};
+    }
 
     virtual ~BaseCommand() = default;
 };
 
+// binary operation dispatched by table of operand type tags, no type tests are done on call
 class ArithmeticCommand : public BaseCommand {
+public:
+    using Operation = sptrObj (*)(const sptrObj &, const sptrObj &);
+    using Estimator = CostEstimate (*)(const CostEstimate &, const CostEstimate &);
+
+    struct Rule {
+        object_type lhs, rhs;
+        Operation operation;
+    };
+
 private:
-    std::function<sptrObj(sptrObj, sptrObj)> func_;
+    std::array<std::array<Operation, ObjectTypesCount>, ObjectTypesCount> table_{}; // [lhs tag][rhs tag]
+    std::string error_; // message for operands without rule
+    Estimator estimator_;
 
 public:
-    ArithmeticCommand(std::function<sptrObj(sptrObj, sptrObj)> &&);
+    ArithmeticCommand(std::initializer_list<Rule>, std::string, Estimator);
+
+    sptrObj Run(std::vector<sptrObj> &) override;
 
-    sptrObj Run(std::list<sptrObj> &) override;
+    [[nodiscard]] CostEstimate Estimate(const std::vector<CostEstimate> &) const override;
 };
 
 
+// text is formatted into reusable buffer which is written to stream in big chunks, matrices line by line;
+// print statements never run at once, so buffer needs no lock
 class PrintCommand : public BaseCommand {
 private:
     std::ostream &out_;
+    std::string buffer_;
+
+    void Write(); // moves buffer content to stream
+
 public:
     PrintCommand(std::ostream &);
 
-    sptrObj Run(std::list<sptrObj> &) override;
+    sptrObj Run(std::vector<sptrObj> &) override;
+
+    [[nodiscard]] bool IsPure() const override {
+        return false;
+    }
+
+    [[nodiscard]] CostEstimate Estimate(const std::vector<CostEstimate> &) const override;
 };
 
 class TransposeCommand : public BaseCommand {
 public:
     TransposeCommand();
 
-    sptrObj Run(std::list<sptrObj> &) override;
+    sptrObj Run(std::vector<sptrObj> &) override;
+
+    [[nodiscard]] CostEstimate Estimate(const std::vector<CostEstimate> &) const override;
 };
 
 
 class LinearTransformationCommand : public BaseCommand {
 private:
     int mode_;
+    cmd::PivotMode pivot_mode_;
+
+    bool SelectPivot(std::vector<std::vector<sptrObj>> &, size_t, size_t, size_t, size_t &) const;
+
+    // builds result of det, inv or to_triangle from blocked LU decomposition
+    sptrObj FromLU(std::vector<std::vector<sptrObj>> &, const std::vector<size_t> &, size_t) const;
+
+    sptrObj Transform(const Matrix &) const; // computes result, Run looks it up in ResultCache first
+
+public:
+    LinearTransformationCommand(int, cmd::PivotMode = cmd::min_bitsize);
+
+    [[nodiscard]] std::shared_ptr<LinearTransformationCommand> WithPivotMode(cmd::PivotMode) const;
+
+    // returns count of performed row and column swaps
+    size_t MakeTransform(std::vector<std::vector<sptrObj>> &, size_t, size_t) const;
+
+    sptrObj Run(std::vector<sptrObj> &) override;
+
+    [[nodiscard]] CostEstimate Estimate(const std::vector<CostEstimate> &) const override;
+};
+
+
+class CharPolyCommand : public BaseCommand {
+private:
+    cmd::PivotMode pivot_mode_;
+
+public:
+    CharPolyCommand(cmd::PivotMode = cmd::min_bitsize);
+
+    sptrObj Run(std::vector<sptrObj> &) override;
+
+    [[nodiscard]] CostEstimate Estimate(const std::vector<CostEstimate> &) const override;
+};
+
+class PolyEvalCommand : public BaseCommand {
+public:
+    PolyEvalCommand();
+
+    sptrObj Run(std::vector<sptrObj> &) override;
+};
+
+// reads matrix from file, it is never run ahead of execution since file may be changed by then (by save too)
+class LoadCommand : public BaseCommand {
+private:
+    std::string root_; // directory paths are resolved in, any path is allowed if it is empty
+
+public:
+    explicit LoadCommand(std::string = "");
+
+    sptrObj Run(std::vector<sptrObj> &) override;
+
+    [[nodiscard]] bool IsPure() const override {
+        return false;
+    }
+};
+
+// writes matrix to file in binary format, load reads it back
+class SaveCommand : public BaseCommand {
+private:
+    std::string root_;
+
+public:
+    explicit SaveCommand(std::string = "");
+
+    sptrObj Run(std::vector<sptrObj> &) override;
+
+    [[nodiscard]] bool IsPure() const override {
+        return false;
+    }
+
+    [[nodiscard]] CostEstimate Estimate(const std::vector<CostEstimate> &) const override;
+};
+
+// snapshot("file") writes all variables of workspace to file, restore("file") binds them back;
+// they see workspace as of their statement, so interpreter runs statements before them first
+class WorkspaceCommand : public BaseCommand {
+private:
+    Dispatcher &workspace_;
+    bool is_restore_;
+    std::string root_;
 
 public:
-    LinearTransformationCommand(int);
+    WorkspaceCommand(Dispatcher &, bool, std::string = "");
 
-    void MakeTransform(std::vector<std::vector<sptrObj>> &, size_t, size_t) const;
+    sptrObj Run(std::vector<sptrObj> &) override;
 
-    sptrObj Run(std::list<sptrObj> &) override;
+    [[nodiscard]] bool IsPure() const override {
+        return false;
+    }
 };
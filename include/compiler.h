@@ -0,0 +1,69 @@
+#pragma once
+
+#include "bytecode.h"
+#include "dispatcher.h"
+
+#include <list>
+#include <map>
+#include <optional>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#ifndef MATLANG_COMPILER_H
+#define MATLANG_COMPILER_H
+
+
+// translates parsed script (result of ReadScript) into register bytecode
+class Compiler {
+private:
+    Dispatcher &dispatcher_;
+    Program program_;
+    std::unordered_map<uint32_t, uint32_t> variable_slots_, command_slots_; // by symbol id
+    std::vector<bool> is_stored_;
+    std::vector<uint32_t> versions_;    // number of stores to variable slot so far
+    // (op, operand, args...) of pure instructions to register which already holds their result
+    std::map<std::vector<uint32_t>, uint32_t> value_numbers_;
+    std::optional<std::set<std::string>> exports_; // variables visible after program, all if not set
+    uint32_t statement_ = 0; // index of statement being compiled
+
+    uint32_t SymbolId(const sptrObj &); // of name of Symbol, interned in workspace
+
+    uint32_t VariableSlot(uint32_t);
+
+    uint32_t CommandSlot(uint32_t);
+
+    uint32_t Constant(sptrObj);
+
+    uint32_t Emit(bc::op_code, uint32_t, const std::vector<uint32_t> & = {});
+
+    // drops instructions which neither print nor feed exported variables: binding nothing depends on is never
+    // evaluated, so its errors (invalid arguments, unknown names) are not raised either
+    void RemoveDeadCode();
+
+    void FoldConstants(); // computes live pure calls on values known before execution
+
+    void RemoveUnusedConstants();
+
+    void BuildStatements(); // splits code by statements and finds which of them depend on which
+
+    uint32_t CompileObject(const sptrObj &); // returns register holding value of object
+
+    uint32_t CompileExpression(const std::shared_ptr<Expression> &);
+
+    uint32_t CompileMatrix(const std::shared_ptr<Matrix> &);
+
+    void CompileStatement(const sptrObj &);
+
+    // snapshot or restore, they are allowed only as statements on their own
+    [[nodiscard]] bool IsWorkspaceCall(const std::shared_ptr<CommandObject> &) const;
+
+public:
+    explicit Compiler(Dispatcher &);
+
+    void SetExports(std::optional<std::set<std::string>>);
+
+    Program Compile(const std::list<sptrObj> &);
+};
+
+#endif //MATLANG_COMPILER_H
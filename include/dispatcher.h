@@ -4,61 +4,71 @@
 #include "object.h"
 #include "rational.h"
 #include "matrix.h"
+#include "lazy_matrix.h"
 #include "expression.h"
 #include "comm.h"
+#include "symbol_table.h"
 
 #include <map>
 #include <memory>
+#include <optional>
 #include <stack>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 
 #ifndef MATLANG_DISPATCHER_H
 #define MATLANG_DISPATCHER_H
 
 
-class Dispatcher;
-
-class Deleter {
+// workspace of one session: its variables and commands; standard commands are immutable and shared by
+// all dispatchers, so different dispatchers can be used from different threads without locking
+class Dispatcher {
 private:
-    friend Dispatcher;
+    // names of commands are in shared symbol table, other names of this workspace are in its own one, so memory
+    // of long-lived process does not grow with names of finished sessions; ids of own names have kOwnSymbol bit
+    static constexpr uint32_t kOwnSymbol = 1u << 31;
 
-    Dispatcher *held_dp_;
+    // commands are indexed by symbol id, so calls do no hashing or string comparison; variables are keyed by it
+    std::vector<std::shared_ptr<BaseCommand>> registers_;  // standard functions
+    std::unordered_map<uint32_t, std::shared_ptr<Object>> variables_;  // user variables
+    SymbolTable symbols_;
+
+    static const std::vector<std::shared_ptr<BaseCommand>> &StandardCommands(); // built once per process
 
 public:
-    void Init(Dispatcher *held_dp);
+    Dispatcher();
 
-    ~Deleter() noexcept;
-};
+    uint32_t Intern(std::string_view);
 
-class Dispatcher {
-private:
-    friend Deleter;
+    [[nodiscard]] std::optional<uint32_t> FindSymbol(std::string_view) const; // lookup only, like SymbolTable::Find
 
-    static Dispatcher *instance;
-    static Deleter deleter;
+    [[nodiscard]] const std::string &Name(uint32_t) const;
 
-    std::map<std::string, std::shared_ptr<BaseCommand>> registers_;  // standard functions
-    std::map<std::string, std::shared_ptr<Object>> variables_;  // user variables
+    [[nodiscard]] bool IsRegisteredSymbol(uint32_t) const;
 
-    Dispatcher();
+    [[nodiscard]] std::shared_ptr<Object> At(uint32_t) const; // nullptr if there is no such
 
-    static bool IsArithmeticOperation(const std::shared_ptr<Object> &);
+    [[nodiscard]] std::shared_ptr<Object> At(const std::string &) const;
 
-public:
-    static Dispatcher &Instance();
+    void ValidateName(uint32_t) const; // throws if variable can't have such name
 
-    bool IsRegisteredSymbol(const std::string &);
+    [[nodiscard]] std::vector<std::pair<uint32_t, std::shared_ptr<Object>>> Variables() const; // bound ones by id
 
-    [[nodiscard]] std::shared_ptr<Object> At(const std::string &) const;
+    void InitObject(uint32_t, std::shared_ptr<Object>);
 
     void InitObject(const std::string &, std::shared_ptr<Object>);
 
-    std::shared_ptr<Object> Eval(std::list<std::shared_ptr<Object>> &);
+    [[nodiscard]] std::shared_ptr<BaseCommand> Find(uint32_t) const; // nullptr if there is no such
+
+    [[nodiscard]] std::shared_ptr<BaseCommand> Find(const std::string &) const;
 
-    std::shared_ptr<Object> Invoke(const std::string &, std::list<std::shared_ptr<Object>> &);
+    std::shared_ptr<Object> Call(const std::shared_ptr<BaseCommand> &, std::vector<std::shared_ptr<Object>> &);
 
     void SetCommand(const std::string&, std::shared_ptr<BaseCommand>);
+
+    void SetPivotMode(cmd::PivotMode); // for this dispatcher only
 };
 
 
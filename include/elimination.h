@@ -0,0 +1,36 @@
+#pragma once
+
+#include "object.h"
+#include "rational.h"
+#include "matrix.h"
+#include "comm.h"
+
+#include <vector>
+
+#ifndef MATLANG_ELIMINATION_H
+#define MATLANG_ELIMINATION_H
+
+
+// blocks not wider than this are eliminated row by row, larger ones are split in halves
+constexpr size_t kBlockSize = 64;
+
+// recursive LU decomposition with row pivoting of square matrix: P * A = L * U;
+// result is stored in place (L under diagonal, its unit diagonal is implied, U on and over diagonal),
+// permutation[k] is index of source line which became line k;
+// most of the work is done by products of the trailing blocks, so it goes through Matrix::Multiply;
+// returns false if zero pivot column was met (matrix is singular), data is partially transformed then
+bool BlockLU(std::vector<std::vector<sptrObj>> &, std::vector<size_t> &, size_t &, cmd::PivotMode);
+
+// rank of square matrix modulo prime 2^61 - 1 in machine arithmetic, so it costs much less than BlockLU;
+// true means BlockLU is sure to succeed, false - matrix is singular (or, very rarely, not invertible modulo prime)
+bool IsNonsingularModPrime(const std::vector<std::vector<sptrObj>> &);
+
+// inverse matrix by result of BlockLU: A^-1 = U^-1 * L^-1 * P
+std::vector<std::vector<sptrObj>> InverseFromLU(const std::vector<std::vector<sptrObj>> &,
+                                                const std::vector<size_t> &);
+
+// reduces square matrix in place to upper Hessenberg form by similarity transformations
+// (elementary eliminations with pivoting), so characteristic polynomial is kept
+void ReduceToHessenberg(std::vector<std::vector<sptrObj>> &, cmd::PivotMode);
+
+#endif //MATLANG_ELIMINATION_H
@@ -3,11 +3,15 @@
 #include "matrix.h"
 #include "parser.h"
 #include "dispatcher.h"
+#include "compiler.h"
+#include "vm.h"
 
 #include <functional>
 #include <iostream>
 #include <list>
 #include <map>
+#include <optional>
+#include <set>
 #include <sstream>
 #include <vector>
 
@@ -15,22 +19,77 @@
 #define MATLANG_INTERPRETER_H
 
 
+// script which is parsed, checked and compiled once and then can be run many times with different inputs;
+// it refers to names of its interpreter, so it is run only by the interpreter which prepared it
+class PreparedScript {
+private:
+    friend class Interpreter;
+
+    Program program_;
+    std::vector<std::string> parameters_;
+
+    PreparedScript(Program &&, std::vector<std::string>);
+
+public:
+    // variables which script reads before defining them, they are expected to be bound on run
+    [[nodiscard]] std::vector<std::string> Parameters() const;
+};
+
+
 class Interpreter {
 private:
-    Dispatcher operation_holder_ = Dispatcher::Instance();
+    Dispatcher operation_holder_; // workspace of this interpreter
     std::ostream& out_;
+    std::optional<std::set<std::string>> exports_;
+    Scheduler *scheduler_ = &Scheduler::Shared(); // runs independent parts of scripts concurrently
 
 public:
     explicit Interpreter(std::ostream& out = std::cout) : out_(out) {
         operation_holder_.SetCommand("print", std::make_shared<PrintCommand>(out_));
+        operation_holder_.SetCommand("snapshot", std::make_shared<WorkspaceCommand>(operation_holder_, false));
+        operation_holder_.SetCommand("restore", std::make_shared<WorkspaceCommand>(operation_holder_, true));
     };
 
+    // snapshot and restore refer to workspace of this object, so a copy or moved-to one would use a wrong one
+    Interpreter(const Interpreter &) = delete;
+
+    Interpreter &operator=(const Interpreter &) = delete;
+
 private:
-    std::shared_ptr<Object> Simplify(std::shared_ptr<Object> &);
+    void Execute(Tokenizer *);
+
+    void Execute(const std::list<std::shared_ptr<Object>> &, const std::optional<std::set<std::string>> &);
+
+    [[nodiscard]] bool IsWorkspaceStatement(const std::shared_ptr<Object> &) const; // snapshot or restore
 
 public:
     void Run(const std::string &);
-    void Run();
+    void Run(); // script from standard input, it is mapped if input is redirected from file
+
+    void RunFile(const std::string &); // file is mapped, not read
+
+    // executes statements one by one as soon as each is read and flushes output after it, so memory does not
+    // grow with script; later statements are unknown, so all variables are kept and statements are not run concurrently;
+    // error of a statement is printed to output, the rest of it is skipped up to `;` and next statements are run
+    void RunStream(std::istream &);
+
+    // throws the same errors as Run would, but before anything is executed;
+    // snapshot and restore are not allowed, since prepared script is run as a whole
+    PreparedScript Prepare(const std::string &);
+
+    void Run(const PreparedScript &, const std::map<std::string, std::shared_ptr<Object>> & = {});
+
+    // variables which must be kept after run (all by default), bindings nothing depends on are not evaluated
+    void SetExports(std::optional<std::set<std::string>>);
+
+    // nullptr runs everything one by one
+    void SetScheduler(Scheduler *);
+
+    // pivoting of elimination (min_bitsize by default), results of to_diag and to_triangle depend on it
+    void SetPivotMode(cmd::PivotMode);
+
+    // load, save, snapshot and restore resolve paths in this directory and can't leave it; empty allows any path
+    void SetFileRoot(const std::string &);
 };
 
 #endif //MATLANG_INTERPRETER_H
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#ifndef MATLANG_MAPPED_FILE_H
+#define MATLANG_MAPPED_FILE_H
+
+
+// whole file mapped into memory read-only, so it is read without copying
+class MappedFile {
+private:
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+
+    void Map(int, const std::string &);
+
+public:
+    explicit MappedFile(const std::string &);
+
+    explicit MappedFile(int); // descriptor is not closed by MappedFile
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    ~MappedFile();
+
+    [[nodiscard]] std::string_view View() const;
+
+    [[nodiscard]] static bool IsMappable(int); // regular files only, pipes and terminals are read as streams
+};
+
+#endif //MATLANG_MAPPED_FILE_H
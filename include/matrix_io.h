@@ -0,0 +1,65 @@
+#pragma once
+
+#include "object.h"
+#include "matrix.h"
+#include "lazy_matrix.h"
+#include "polynomial.h"
+#include "scheduler.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#ifndef MATLANG_MATRIX_IO_H
+#define MATLANG_MATRIX_IO_H
+
+
+// reading and writing matrices in files
+namespace io {
+    // text with matrix line per row and cells separated by delimiter; cell is integer, fraction like -3/4 or
+    // decimal like 1.5e-3; empty rows are skipped; big text is split into chunks of rows parsed as tasks
+    std::shared_ptr<Matrix> ParseDelimited(std::string_view, char, Scheduler * = nullptr);
+
+    // binary format, numbers are little-endian:
+    //   header: magic "MLBM", version byte, encoding byte, 2 zero bytes,
+    //           lines u64, columns u64, common denominator i64 (1 if it is not used), payload size u64
+    //   payload: cells line by line, each is numerator and denominator or only numerator with common denominator,
+    //            numbers are int64 or zigzag varints (7 bits per byte, the lowest first)
+    // writer picks the smallest encoding, int64 cells are decoded in chunks of lines as tasks
+    enum Encoding : uint8_t {
+        kVarint = 1,
+        kCommonDenominator = 2,
+    };
+
+    constexpr size_t kHeaderSize = 40;
+
+    void EncodeMatrix(const Matrix &, std::string *); // appends encoded matrix
+
+    std::shared_ptr<Matrix> DecodeMatrix(std::string_view, Scheduler * = nullptr);
+
+    void SaveMatrix(const Matrix &, const std::string &); // binary format whatever extension is
+
+    // workspace snapshot, numbers are little-endian:
+    //   header: magic "MLBS", version byte, 3 zero bytes, count of variables u64
+    //   variable: name size u32, name, kind byte, value size u64, value
+    //   value: rational is numerator and denominator i64, string is its bytes, matrix is in binary format above,
+    //          polynomial is binary 1 x (degree + 1) matrix of its coefficients from the lowest one
+    using Variables = std::vector<std::pair<std::string, sptrObj>>;
+
+    void SaveWorkspace(const Variables &, const std::string &); // file is replaced at once, not rewritten
+
+    // file is mapped, big matrices are restored as deferred ones and decoded only when they are read first
+    Variables LoadWorkspace(const std::string &);
+
+    // file is mapped, format is chosen by extension: .mlb is binary, .tsv is split by tabs, anything else by commas
+    std::shared_ptr<Matrix> LoadMatrix(const std::string &);
+
+    // path of script file in root directory; empty root allows any path, otherwise absolute paths and `..`
+    // are rejected, so scripts of one server session can't reach files outside of its directory
+    std::string ResolvePath(const std::string &, const std::string &);
+}
+
+#endif //MATLANG_MATRIX_IO_H
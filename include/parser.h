@@ -11,10 +11,17 @@
 
 std::list<std::shared_ptr<Object>> ReadScript(Tokenizer *);
 
+// reads statement till its semicolon, which is left as current token; nullptr for empty statement
+std::shared_ptr<Object> ReadStatement(Tokenizer *);
+
 std::shared_ptr<Object> Read(Tokenizer *, size_t = 0);
 
 std::shared_ptr<Object> ReadExpression(Tokenizer *, bool * = nullptr);
 
+std::shared_ptr<Object> ReadOperation(Tokenizer *, int);
+
+std::shared_ptr<Object> ReadOperand(Tokenizer *);
+
 std::shared_ptr<Object> ReadCommandArgs(Tokenizer *, std::shared_ptr<Object>);
 
 std::shared_ptr<Object> ReadMatrix(Tokenizer *);
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef MATLANG_SCHEDULER_H
+#define MATLANG_SCHEDULER_H
+
+
+// work-stealing scheduler for fork-join computations: worker takes the newest task of its own deque,
+// idle one steals the oldest task of another; thread waiting in Wait runs meanwhile only not started tasks of
+// its own group (those it spawned), never unrelated ones: such task could wait for work suspended under it
+// on the same stack, and the thread would deadlock
+class Scheduler {
+private:
+    struct Task {
+        std::function<void()> function;
+        const void *group;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues_; // one per worker and the last one for threads outside
+    std::vector<std::thread> workers_;
+    size_t queued_count_ = 0;
+    std::mutex mutex_;
+    std::condition_variable changed_; // task was spawned or finished, or Notify was called
+    bool is_stopped_ = false;
+
+    [[nodiscard]] size_t OwnQueue() const;
+
+    bool RunOne(size_t); // runs task from given queue or stolen one, false if there is none
+
+    bool RunOwn(size_t, const void *); // runs task of group from given queue, false if there is none
+
+    bool HasOwn(size_t, const void *); // whether given queue has task of group
+
+    void Run(Task &);
+
+    void Work(size_t);
+
+public:
+    explicit Scheduler(size_t = std::thread::hardware_concurrency());
+
+    Scheduler(const Scheduler &) = delete;
+
+    Scheduler &operator=(const Scheduler &) = delete;
+
+    ~Scheduler(); // spawned tasks are expected to be waited for before
+
+    static Scheduler &Shared(); // process-wide scheduler sized by hardware, it runs scripts
+
+    // group is any address which identifies tasks waited for together, e.g. their counter
+    void Spawn(std::function<void()>, const void *group = nullptr);
+
+    // runs tasks of group until condition holds; without group it only blocks
+    void Wait(const std::function<bool()> &, const void *group = nullptr);
+
+    void Notify(); // condition of Wait was changed outside of task
+
+    [[nodiscard]] size_t Size() const;
+};
+
+#endif //MATLANG_SCHEDULER_H
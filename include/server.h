@@ -0,0 +1,71 @@
+#pragma once
+
+#include "interpreter.h"
+#include "thread_pool.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#ifndef MATLANG_SERVER_H
+#define MATLANG_SERVER_H
+
+
+// long-lived interpreter service on unix socket or, when address is a port number, on tcp port of localhost
+// (unix socket of wsl can't be reached from windows); every frame is 4 bytes of big-endian payload length and payload;
+// request payload is session id, `\n` and script, response payload is status (`0` - ok, `1` - error) and
+// printed output (followed by error message on error); variables of session live between requests;
+// file commands of scripts are confined to directory of session in `<socket path>.files` (or in
+// `matlang-<port>.files` of temporary directory); sessions idle for
+// an hour are dropped and so is the least recently used one when there are too many, connections are
+// limited in count and closed after ten idle minutes; SIGINT or SIGTERM stops it after running requests
+class Server {
+private:
+    struct Session {
+        std::mutex mutex; // requests of one session are run one by one
+        std::stringstream out;
+        Interpreter interpreter{out};
+        std::string directory; // removed with session
+        std::chrono::steady_clock::time_point last_used; // guarded by sessions_mutex_
+
+        ~Session();
+    };
+
+    std::string address_; // unix socket path or tcp port
+    std::string files_root_; // every session reads and writes files only in its own subdirectory of it
+    ThreadPool pool_;
+    std::mutex sessions_mutex_;
+    std::unordered_map<std::string, std::shared_ptr<Session>> sessions_;
+    size_t sessions_count_ = 0; // names directories, so that session ids never become paths
+    std::mutex connections_mutex_;
+    std::condition_variable connections_closed_;
+    std::unordered_set<int> connections_; // their threads are detached, so server waits for them to stop
+    cmd::PivotMode pivot_mode_ = cmd::min_bitsize; // of every session
+
+    std::shared_ptr<Session> GetSession(const std::string &);
+
+    // drops idle sessions and, if there are still too many, the least recently used one; running requests
+    // keep their session alive until they are done
+    void EvictSessions(std::chrono::steady_clock::time_point, std::vector<std::shared_ptr<Session>> &);
+
+    std::string Process(const std::string &); // returns response payload
+
+    void HandleConnection(int); // doesn't close socket
+
+    int Listen(); // returns listening socket
+
+public:
+    explicit Server(std::string, size_t = std::thread::hardware_concurrency());
+
+    void SetPivotMode(cmd::PivotMode); // before Serve
+
+    void Serve(); // returns after SIGINT or SIGTERM, when all connections are closed
+};
+
+#endif //MATLANG_SERVER_H
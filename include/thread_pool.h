@@ -0,0 +1,37 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#ifndef MATLANG_THREAD_POOL_H
+#define MATLANG_THREAD_POOL_H
+
+
+// fixed set of worker threads running submitted tasks in submission order
+class ThreadPool {
+private:
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable has_task_;
+    bool is_stopped_ = false;
+
+    void Work();
+
+public:
+    explicit ThreadPool(size_t = std::thread::hardware_concurrency());
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    ~ThreadPool(); // waits for all submitted tasks
+
+    void Submit(std::function<void()>);
+};
+
+#endif //MATLANG_THREAD_POOL_H
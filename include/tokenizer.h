@@ -1,8 +1,11 @@
 #pragma once
 
+#include <cstdint>
 #include <variant>
 #include <optional>
 #include <istream>
+#include <string>
+#include <string_view>
 
 #ifndef MATLANG_TOKENIZER_H
 #define MATLANG_TOKENIZER_H
@@ -13,33 +16,47 @@ enum class BracketToken {
 }; // [] (do i need some tokens for {} ()?)
 
 struct SymbolToken {
-    std::string name_;
+    std::string_view name_; // points into input of tokenizer, valid till its next token
 
-    SymbolToken(int);
-
-    SymbolToken(const std::string &);
+    SymbolToken(std::string_view);
 };
 
 struct ConstantToken {
-    int value_;
+    int64_t numerator_, denominator_; // exact value of literal, 1.25 is 125 / 100
+
+    ConstantToken(int64_t, int64_t = 1);
+};
 
-    ConstantToken(int);
+struct StringToken {
+    std::string_view value_; // between quotes, points into input of tokenizer like SymbolToken::name_
 };
 
 struct SemicolonToken {
 };
 
-using Token = std::variant<BracketToken, SymbolToken, ConstantToken, SemicolonToken>;
+using Token = std::variant<BracketToken, SymbolToken, ConstantToken, StringToken, SemicolonToken>;
+
+// reads number like 12, 1.25 or 1.5e-3 from the beginning of text as exact fraction,
+// returns count of read chars (0 if text does not start with digit); throws if it does not fit in int64
+size_t ParseNumber(std::string_view, int64_t *, int64_t *);
 
 class Tokenizer {
 private:
     Token curr_token_;
-    std::istream *in_;
+    std::string_view data_; // input, it is read from position pos_
+    size_t pos_ = 0;
+    std::istream *in_ = nullptr; // if set, data_ is its current line kept in buffer_
+    std::string buffer_;
     bool already_read_ = false;
+    bool is_valid_ = false; // false if last Next() failed, so curr_token_ is left from previous token
 
 public:
-    // Создаёт токенизатор, читающий символы из потока in.
-    explicit Tokenizer(std::istream *);
+    // Создаёт токенизатор, читающий символы из потока in построчно.
+    // Если read_first == false, первый токен читается вызовом Next(), как и остальные, и его ошибку можно обработать.
+    explicit Tokenizer(std::istream *, bool read_first = true);
+
+    // Создаёт токенизатор над готовым текстом без копирования, текст должен жить дольше токенизатора.
+    explicit Tokenizer(std::string_view);
 
     // Достигли мы конца потока или нет.
     bool IsEnd();
@@ -48,17 +65,23 @@ public:
     // Либо IsEnd() станет true, либо токен можно будет получить через GetToken().
     void Next();
 
-    // Получить текущий токен.
-    Token GetToken();
+    // Получить текущий токен, ссылка указывает на текущий токен и после Next().
+    const Token &GetToken() const;
+
+    // Пропустить остаток ошибочной инструкции как текст до следующей `;`, после чего GetToken() вернёт `;`.
+    // Если ошибка случилась уже после `;`, ничего не пропускается.
+    void SkipStatement();
 
 private:
-    int ReadNumber(); // reads number till first non-digit symbol
+    ConstantToken ReadNumber(); // reads digits[.digits][e[+-]digits]
+
+    std::string_view ReadSymbol(); // reads string-type value till first space symbol
 
-    std::string ReadSymbol(); // reads string-type value till first space symbol
+    std::string_view ReadString(); // reads "text" without escapes, it must end on the same line
 
-    void ClearSpace(); // reads space symbols till first non-space symbol
+    void ClearSpace(); // reads space symbols till first non-space symbol, asks stream for more lines
 
-    bool OnEOF(); // returns true on eof
+    bool OnEOF() const; // returns true if nothing is left in data_
 
     constexpr static bool IsSpecialSymbol(int); // special symbols reserved by system
     constexpr static bool IsProhibitedSymbol(int); // prohibited by language syntax symbols
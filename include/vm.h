@@ -0,0 +1,54 @@
+#pragma once
+
+#include "bytecode.h"
+#include "dispatcher.h"
+#include "scheduler.h"
+
+#include <atomic>
+#include <exception>
+#include <map>
+#include <memory>
+#include <vector>
+
+#ifndef MATLANG_VM_H
+#define MATLANG_VM_H
+
+
+// executes Program; registers and variable slots are allocated once per program, not per operation
+class VirtualMachine {
+private:
+    Dispatcher &dispatcher_;
+    Scheduler *scheduler_;
+    std::vector<sptrObj> registers_;
+    std::vector<sptrObj> variables_;
+
+    // used only when scheduler has several workers
+    std::vector<uint32_t> producers_;       // instruction which computes register
+    std::vector<CostEstimate> estimates_;   // of register, cost is of all its statement part it depends on
+    std::vector<uint32_t> uses_;            // reads of register within its statement
+    std::unique_ptr<std::atomic<uint8_t>[]> states_; // of instructions: pending, running or done
+    std::vector<std::exception_ptr> errors_; // of instructions
+
+    void ExecuteInstruction(const Program &, const Instruction &, std::vector<sptrObj> &);
+
+    bool Plan(const Program &, const Statement &); // estimates statement, true if it has subtrees worth tasks
+
+    void Evaluate(const Program &, const Statement &, uint32_t, bool); // runs instruction once, after its arguments
+
+    void RunStatement(const Program &, const Statement &, std::vector<sptrObj> &);
+
+    void Commit(const Program &, const Statement &); // stores values of statement variables to dispatcher
+
+    void RunConcurrently(const Program &);
+
+public:
+    // independent statements and heavy independent parts of expressions are run on scheduler;
+    // without it everything is run one by one
+    explicit VirtualMachine(Dispatcher &, Scheduler * = nullptr);
+
+    // bindings are values of program parameters for this run, they take precedence over dispatcher variables;
+    // variables are changed in statement order, up to the first statement which failed
+    void Execute(const Program &, const std::map<std::string, sptrObj> & = {});
+};
+
+#endif //MATLANG_VM_H
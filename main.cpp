@@ -1,7 +1,89 @@
 #include "interpreter.h"
+#include "cache.h"
+#include "server.h"
 
-int main() {
-    Interpreter interpreter;
-    interpreter.Run();
-    return 0;
+#include <filesystem>
+#include <string_view>
+
+namespace {
+    // results of previous runs are loaded from cache file before the run, all results are saved back after it
+    bool LoadCache(const std::string &path) { // false if file is not a cache, it is not overwritten then
+        if (path.empty() || !std::filesystem::exists(path)) {
+            return true;
+        }
+        try {
+            ResultCache::Instance().Load(path);
+        } catch (const std::exception &e) { // cache only saves time, so the run goes on without it
+            std::cerr << e.what();
+            return false;
+        }
+        return true;
+    }
+
+    void SaveCache(const std::string &path) {
+        if (path.empty()) {
+            return;
+        }
+        ResultCache &cache = ResultCache::Instance();
+        try {
+            cache.Save(path);
+        } catch (const std::exception &e) {
+            std::cerr << e.what();
+        }
+        std::cerr << "ResultCache: " << cache.Hits() << " hits, " << cache.Misses() << " misses\n";
+    }
+
+    int Run(int argc, char *argv[], cmd::PivotMode pivot_mode) {
+        if (argc > 1 && std::string_view(argv[1]) == "--serve") { // matlang --serve [socket path | port]
+            try {
+                Server server(argc > 2 ? argv[2] : "/tmp/matlang.sock");
+                server.SetPivotMode(pivot_mode);
+                server.Serve();
+            } catch (const std::exception &e) { // socket can't be listened
+                std::cerr << e.what();
+                return 1;
+            }
+            return 0;
+        }
+        Interpreter interpreter;
+        interpreter.SetPivotMode(pivot_mode);
+        if (argc > 1 && std::string_view(argv[1]) == "--stream") { // statements are run as they are typed or piped
+            interpreter.RunStream(std::cin);
+            return 0;
+        }
+        interpreter.SetExports(std::set<std::string>{}); // nothing is left after script, so only printed values count
+        if (argc > 1) { // matlang script.ml
+            interpreter.RunFile(argv[1]);
+        } else {
+            interpreter.Run();
+        }
+        return 0;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    cmd::PivotMode pivot_mode = cmd::min_bitsize;
+    std::string cache_path;
+    for (; argc > 1; --argc, ++argv) { // matlang [--pivot=first_nonzero] [--cache=file] ...
+        std::string_view option = argv[1];
+        if (option.starts_with("--pivot=")) {
+            std::string_view name = option.substr(std::string_view("--pivot=").size());
+            if (name == "first_nonzero") {
+                pivot_mode = cmd::first_nonzero;
+            } else if (name != "min_bitsize") {
+                std::cerr << "unknown pivot mode " << name << ", first_nonzero or min_bitsize was expected\n";
+                return 1;
+            }
+        } else if (option.starts_with("--cache=")) {
+            cache_path = option.substr(std::string_view("--cache=").size());
+        } else {
+            break;
+        }
+    }
+    bool is_cache_loaded = LoadCache(cache_path);
+    int code = Run(argc, argv, pivot_mode);
+    if (code == 0 && is_cache_loaded) {
+        SaveCache(cache_path);
+    }
+    return code;
 }
@@ -1,8 +1,12 @@
 #!venv/bin/python
 
+import asyncio
 import logging
+import socket
+import struct
 import sys
 import subprocess
+import time
 from os import getenv
 
 from aiogram import Bot, Dispatcher, executor, types
@@ -12,27 +16,61 @@ dp = Dispatcher(bot)
 logging.basicConfig(stream=sys.stderr, level=logging.INFO)
 
 
-def run_matlang_script(script: str):
-    return subprocess.run(["wsl", "--exec", "./matlang"],
-                          input=script.encode("utf-8"),
-                          stdout=subprocess.PIPE,
-                          stderr=subprocess.PIPE,
-                          shell=True)
+# tcp port of localhost: unix socket of wsl can't be reached from windows
+SERVER_PORT = 8765
+SERVER_START_TIMEOUT = 30
+# on windows interpreter is built and run in wsl
+WSL_PREFIX = ["wsl", "--exec"] if sys.platform == "win32" else []
+
+
+async def run_matlang_script(session: str, script: str):
+    # one request to `matlang --serve`: frames are 4-byte big-endian length and payload
+    reader, writer = await asyncio.open_connection("127.0.0.1", SERVER_PORT)
+    payload = (session + "\n" + script).encode("utf-8")
+    writer.write(struct.pack(">I", len(payload)) + payload)
+    await writer.drain()
+    size, = struct.unpack(">I", await reader.readexactly(4))
+    response = (await reader.readexactly(size)).decode("utf-8")
+    writer.close()
+    return response[0] == "0", response[1:]
+
+
+def format_reply(ok: bool, output: str):
+    # on error output is printed text followed by error message; empty message can't be sent
+    if ok:
+        return "`" + output + "`" if output else "`ok`"
+    return "Error:\n`" + output + "`"
 
 
 @dp.message_handler()
 async def code(message: types.Message):
-    output = run_matlang_script(message.text)
-    if output.returncode != 0:
-        await message.reply("`" + output.stderr.decode("utf-8") + "`",
-                            parse_mode="Markdown")
-    else:
-        await message.reply("`" + output.stdout.decode("utf-8") + "`",
-                            parse_mode="Markdown")
+    try:
+        ok, output = await run_matlang_script(str(message.chat.id), message.text)
+    except (OSError, asyncio.IncompleteReadError) as error:
+        logging.exception("matlang server is unavailable")
+        ok, output = False, "matlang server is unavailable: " + str(error)
+    await message.reply(format_reply(ok, output), parse_mode="Markdown")
+
+
+def wait_for_server(server: subprocess.Popen):
+    # server is ready only when connection is accepted
+    deadline = time.monotonic() + SERVER_START_TIMEOUT
+    while True:
+        if server.poll() is not None:
+            raise RuntimeError("matlang server exited with code " + str(server.returncode))
+        try:
+            socket.create_connection(("127.0.0.1", SERVER_PORT)).close()
+            return
+        except OSError:
+            if time.monotonic() > deadline:
+                raise RuntimeError("matlang server did not listen port " + str(SERVER_PORT))
+            time.sleep(0.1)
 
 
 if __name__ == "__main__":
-    built = subprocess.run(["wsl", "--exec", "./build.sh"], shell=True)
+    built = subprocess.run(WSL_PREFIX + ["./build.sh"])
     if built.returncode != 0:
         raise RuntimeError(built.args)
+    server = subprocess.Popen(WSL_PREFIX + ["./matlang", "--serve", str(SERVER_PORT)])
+    wait_for_server(server)
     executor.start_polling(dp, skip_updates=True)
@@ -0,0 +1,226 @@
+#include "cache.h"
+
+#include <fstream>
+
+
+namespace {
+    // rational cell with its two integers and their control blocks
+    constexpr size_t kCellBytes = sizeof(Rational) + 2 * sizeof(Integer) + 3 * 16;
+
+    uint64_t Mix(uint64_t hash, uint64_t value) {
+        hash ^= value + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2);
+        return hash;
+    }
+
+    size_t ResultBytes(const sptrObj &result) {
+        if (Is<Matrix>(result)) {
+            auto [lines, columns] = As<Matrix>(result)->size();
+            return sizeof(Matrix) + lines * (sizeof(std::vector<sptrObj>) + columns * (sizeof(sptrObj) + kCellBytes));
+        }
+        return kCellBytes;
+    }
+
+    void WriteRational(std::ostream &out, const sptrObj &value) {
+        out << As<Rational>(value)->Numerator() << ' ' << As<Rational>(value)->Denominator() << ' ';
+    }
+
+    sptrObj ReadRational(std::istream &in) {
+        int64_t numerator, denominator;
+        if (!(in >> numerator >> denominator) || denominator == 0) {
+            throw RuntimeError("ResultCache::Load: invalid cache file\n");
+        }
+        return std::make_shared<Rational>(numerator, denominator);
+    }
+}
+
+ResultCache &ResultCache::Instance() {
+    static ResultCache instance;
+    return instance;
+}
+
+uint64_t ResultCache::Hash(uint32_t command, const Matrix &matrix) {
+    auto [lines, columns] = matrix.size();
+    uint64_t hash = Mix(Mix(command, lines), columns);
+    for (size_t i = 0; i < lines; ++i) {
+        for (const auto &cell: matrix[i]) {
+            const Rational &value = *As<Rational>(cell);
+            hash = Mix(Mix(hash, value.Numerator()), value.Denominator());
+        }
+    }
+    return hash;
+}
+
+bool ResultCache::IsEqual(const Entry &entry, uint32_t command, const Matrix &matrix) {
+    if (entry.command != command || std::make_pair(entry.lines, entry.columns) != matrix.size()) {
+        return false;
+    }
+    auto key_it = entry.key.begin();
+    for (size_t i = 0; i < entry.lines; ++i) {
+        for (const auto &cell: matrix[i]) {
+            const Rational &value = *As<Rational>(cell);
+            if (key_it->first != value.Numerator() || key_it->second != value.Denominator()) {
+                return false;
+            }
+            ++key_it;
+        }
+    }
+    return true;
+}
+
+sptrObj ResultCache::Find(uint32_t command, const Matrix &matrix) {
+    uint64_t hash = Hash(command, matrix);
+    std::lock_guard lock(mutex_);
+    auto [begin, end] = index_.equal_range(hash);
+    for (auto it = begin; it != end; ++it) {
+        if (IsEqual(*it->second, command, matrix)) {
+            entries_.splice(entries_.begin(), entries_, it->second);
+            ++hits_;
+            return entries_.front().result;
+        }
+    }
+    ++misses_;
+    return nullptr;
+}
+
+void ResultCache::Insert(uint32_t command, const Matrix &matrix, sptrObj result) {
+    auto [lines, columns] = matrix.size();
+    Entry entry{Hash(command, matrix), command, lines, columns, {}, std::move(result), 0};
+    entry.key.reserve(lines * columns);
+    for (const auto &cell: matrix) {
+        entry.key.emplace_back(As<Rational>(cell)->Numerator(), As<Rational>(cell)->Denominator());
+    }
+    entry.bytes = sizeof(Entry) + entry.key.size() * sizeof(entry.key[0]) + ResultBytes(entry.result);
+    std::lock_guard lock(mutex_);
+    Add(std::move(entry));
+}
+
+void ResultCache::Add(Entry &&entry) {
+    if (entry.bytes > limit_) {
+        return;
+    }
+    auto [begin, end] = index_.equal_range(entry.hash);
+    for (auto it = begin; it != end; ++it) { // result could be computed concurrently by someone else
+        const Entry &other = *it->second;
+        if (other.command == entry.command && other.lines == entry.lines && other.key == entry.key) {
+            return;
+        }
+    }
+    EvictTill(limit_ - entry.bytes);
+    bytes_ += entry.bytes;
+    uint64_t hash = entry.hash;
+    entries_.push_front(std::move(entry));
+    index_.emplace(hash, entries_.begin());
+}
+
+void ResultCache::EvictTill(size_t bytes) {
+    while (bytes_ > bytes) {
+        const Entry &entry = entries_.back();
+        auto [begin, end] = index_.equal_range(entry.hash);
+        for (auto it = begin; it != end; ++it) {
+            if (&*it->second == &entry) {
+                index_.erase(it);
+                break;
+            }
+        }
+        bytes_ -= entry.bytes;
+        entries_.pop_back();
+    }
+}
+
+void ResultCache::SetLimit(size_t bytes) {
+    std::lock_guard lock(mutex_);
+    limit_ = bytes;
+    EvictTill(limit_);
+}
+
+void ResultCache::Clear() {
+    std::lock_guard lock(mutex_);
+    entries_.clear();
+    index_.clear();
+    bytes_ = hits_ = misses_ = 0;
+}
+
+size_t ResultCache::Hits() const {
+    std::lock_guard lock(mutex_);
+    return hits_;
+}
+
+size_t ResultCache::Misses() const {
+    std::lock_guard lock(mutex_);
+    return misses_;
+}
+
+size_t ResultCache::Bytes() const {
+    std::lock_guard lock(mutex_);
+    return bytes_;
+}
+
+void ResultCache::Save(const std::string &path) const {
+    // text format: header, then for each entry from least recently used:
+    // command lines columns key cells, `r` and rational or `m` lines columns and matrix cells
+    std::ofstream out(path);
+    if (!out) {
+        throw RuntimeError("ResultCache::Save: can't open file " + path + "\n");
+    }
+    std::lock_guard lock(mutex_);
+    out << "matlang-cache 1 " << entries_.size() << '\n';
+    for (auto it = entries_.rbegin(); it != entries_.rend(); ++it) {
+        out << it->command << ' ' << it->lines << ' ' << it->columns << ' ';
+        for (const auto &[numerator, denominator]: it->key) {
+            out << numerator << ' ' << denominator << ' ';
+        }
+        if (Is<Matrix>(it->result)) {
+            const Matrix &result = *As<Matrix>(it->result);
+            out << "m " << result.size().first << ' ' << result.size().second << ' ';
+            for (const auto &cell: result) {
+                WriteRational(out, cell);
+            }
+        } else {
+            out << "r ";
+            WriteRational(out, it->result);
+        }
+        out << '\n';
+    }
+}
+
+void ResultCache::Load(const std::string &path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw RuntimeError("ResultCache::Load: can't open file " + path + "\n");
+    }
+    std::string header;
+    size_t version, count;
+    if (!(in >> header >> version >> count) || header != "matlang-cache" || version != 1) {
+        throw RuntimeError("ResultCache::Load: invalid cache file\n");
+    }
+    for (size_t entry_index = 0; entry_index < count; ++entry_index) {
+        uint32_t command;
+        size_t lines, columns;
+        if (!(in >> command >> lines >> columns) || lines == 0 || columns == 0) {
+            throw RuntimeError("ResultCache::Load: invalid cache file\n");
+        }
+        Matrix key(lines, columns);
+        for (auto &cell: key) {
+            cell = ReadRational(in);
+        }
+        char kind;
+        sptrObj result;
+        if (!(in >> kind) || (kind != 'm' && kind != 'r')) {
+            throw RuntimeError("ResultCache::Load: invalid cache file\n");
+        }
+        if (kind == 'm') {
+            size_t result_lines, result_columns;
+            if (!(in >> result_lines >> result_columns)) {
+                throw RuntimeError("ResultCache::Load: invalid cache file\n");
+            }
+            std::shared_ptr<Matrix> matrix = std::make_shared<Matrix>(result_lines, result_columns);
+            for (auto &cell: *matrix) {
+                cell = ReadRational(in);
+            }
+            result = matrix;
+        } else {
+            result = ReadRational(in);
+        }
+        Insert(command, key, std::move(result));
+    }
+}
@@ -1,107 +1,265 @@
 #include "comm.h"
+#include "dispatcher.h"
+#include "elimination.h"
+#include "cache.h"
+#include "matrix_io.h"
 
-ArithmeticCommand::ArithmeticCommand(std::function<sptrObj(sptrObj, sptrObj)> &&f)
+#include <algorithm>
+#include <cmath>
+
+ArithmeticCommand::ArithmeticCommand(std::initializer_list<Rule> rules, std::string error, Estimator estimator)
         : BaseCommand(cmd::cmd_type::Arithmetic),
-          func_(std::move(f)) {
+          error_(std::move(error)),
+          estimator_(estimator) {
+    for (const Rule &rule: rules) {
+        table_[rule.lhs][rule.rhs] = rule.operation;
+    }
 }
 
-sptrObj ArithmeticCommand::Run(std::list<sptrObj> &args) {
+sptrObj ArithmeticCommand::Run(std::vector<sptrObj> &args) {
     if (args.size() != 2) {
         throw RuntimeError("ArithmeticCommand: invalid number of arguments for operation\n");
     }
-    return func_(args.front(), args.back());
+    Operation operation = table_[args.front()->GetType()][args.back()->GetType()];
+    if (!operation) {
+        throw RuntimeError(error_);
+    }
+    return operation(args.front(), args.back());
+}
+
+CostEstimate ArithmeticCommand::Estimate(const std::vector<CostEstimate> &args) const {
+    return args.size() == 2 ? estimator_(args.front(), args.back()) : CostEstimate{0, 0, 1};
 }
 
 PrintCommand::PrintCommand(std::ostream& out)
         : BaseCommand(cmd::cmd_type::Print), out_(out) {}
 
-sptrObj PrintCommand::Run(std::list<sptrObj> &args) {
+namespace {
+    constexpr size_t kPrintChunkSize = 1 << 16;
+}
+
+void PrintCommand::Write() {
+    out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    buffer_.clear(); // capacity is kept for next chunks
+}
+
+sptrObj PrintCommand::Run(std::vector<sptrObj> &args) {
+    buffer_.clear(); // text of print which failed is dropped
     for (auto &arg: args) {
-        out_ << arg->GetString() << "\n";
+        if (Is<Matrix>(arg) && As<Matrix>(arg)->size().first > 0) { // big matrix is never held as whole text
+            Matrix &matrix = *As<Matrix>(arg);
+            for (size_t curr_l = 0; curr_l < matrix.size().first; ++curr_l) {
+                matrix.AppendLines(buffer_, curr_l, curr_l + 1);
+                if (buffer_.size() >= kPrintChunkSize) {
+                    Write();
+                }
+            }
+        } else {
+            arg->AppendString(buffer_);
+        }
+        buffer_ += '\n';
     }
+    Write();
     return std::make_shared<NoneObject>();
 }
 
+CostEstimate PrintCommand::Estimate(const std::vector<CostEstimate> &args) const {
+    CostEstimate result{0, 0, 1};
+    for (const auto &arg: args) {
+        result.cost += double(arg.lines) * arg.columns;
+    }
+    return result;
+}
+
 TransposeCommand::TransposeCommand()
         : BaseCommand(cmd::cmd_type::Transpose) {}
 
-sptrObj TransposeCommand::Run(std::list<sptrObj> &args) {
+sptrObj TransposeCommand::Run(std::vector<sptrObj> &args) {
     if (args.size() != 1) {
         throw RuntimeError("TransposeCommand: invalid number of arguments to transpose\n");
     }
-    if (Is<Matrix>(args.front())) {
-        return As<Matrix>(args.front())->Transposed();
+    if (IsMatrixLike(args.front())) { // only a view, real transposition is done on consuming
+        return std::make_shared<LazyMatrix>(LazyMatrix::Of(args.front()));
     }
     throw RuntimeError("TransposeCommand: invalid value was provided to transpose\n");
 }
 
+CostEstimate TransposeCommand::Estimate(const std::vector<CostEstimate> &args) const {
+    if (args.size() != 1) {
+        return {0, 0, 1};
+    }
+    return {args.front().columns, args.front().lines, double(args.front().lines) * args.front().columns + 1};
+}
+
 
-LinearTransformationCommand::LinearTransformationCommand(int mode)
+LinearTransformationCommand::LinearTransformationCommand(int mode, cmd::PivotMode pivot_mode)
         : BaseCommand(cmd::MatrixLinearTransform),
-          mode_(mode) {}
+          mode_(mode),
+          pivot_mode_(pivot_mode) {}
+
+std::shared_ptr<LinearTransformationCommand> LinearTransformationCommand::WithPivotMode(
+        cmd::PivotMode pivot_mode) const {
+    // rank counts nonzero diagonal cells, so it is right only with column swaps and keeps complete pivoting
+    return std::make_shared<LinearTransformationCommand>(mode_, mode_ == cmd::rank ? pivot_mode_ : pivot_mode);
+}
+
+CostEstimate LinearTransformationCommand::Estimate(const std::vector<CostEstimate> &args) const {
+    if (args.size() != 1) {
+        return {0, 0, 1};
+    }
+    auto [lines, columns, cost] = args.front();
+    cost = double(lines) * columns * std::min(lines, columns) + 1; // elimination
+    if (mode_ == cmd::det || mode_ == cmd::rank) {
+        return {0, 0, cost};
+    }
+    return {lines, columns, cost};
+}
 
-void LinearTransformationCommand::MakeTransform(std::vector<std::vector<sptrObj>> &data, size_t rows_count,
-                                                size_t columns_count) const {
-    size_t curr_row = 0;
+static bool IsZero(const sptrObj &value) {
+    return As<Rational>(value)->Numerator() == 0;
+}
+
+bool LinearTransformationCommand::SelectPivot(std::vector<std::vector<sptrObj>> &data, size_t curr_row,
+                                              size_t rows_count, size_t columns_count, size_t &swaps_count) const {
+    // moves chosen pivot to data[curr_row][curr_row], returns false if there is no nonzero pivot
+    bool use_columns = pivot_mode_ == cmd::complete && mode_ == cmd::rank;
+    size_t last_column = use_columns ? columns_count : curr_row + 1;
+    size_t pivot_row = rows_count, pivot_column = curr_row, pivot_size = 0;
+    for (size_t k = curr_row; k < rows_count; ++k) {
+        for (size_t c = curr_row; c < last_column; ++c) {
+            if (IsZero(data[k][c])) {
+                continue;
+            }
+            size_t size = pivot_mode_ == cmd::first_nonzero ? 0 : As<Rational>(data[k][c])->BitSize();
+            if (pivot_row == rows_count || size < pivot_size) {
+                pivot_row = k;
+                pivot_column = c;
+                pivot_size = size;
+            }
+        }
+        if (pivot_row != rows_count && pivot_mode_ == cmd::first_nonzero) {
+            break;
+        }
+    }
+    if (pivot_row == rows_count) {
+        return false;
+    }
+    if (pivot_row != curr_row) {
+        std::swap(data[pivot_row], data[curr_row]);
+        ++swaps_count;
+    }
+    if (pivot_column != curr_row) {
+        for (size_t k = 0; k < rows_count; ++k) {
+            std::swap(data[k][pivot_column], data[k][curr_row]);
+        }
+        ++swaps_count;
+    }
+    return true;
+}
+
+size_t LinearTransformationCommand::MakeTransform(std::vector<std::vector<sptrObj>> &data, size_t rows_count,
+                                                  size_t columns_count) const {
+    size_t swaps_count = 0;
     std::shared_ptr<Evaluable> div, mul_cf;
-    while (curr_row < rows_count) {
+    for (size_t curr_row = 0; curr_row < std::min(rows_count, columns_count); ++curr_row) {
+        if (!SelectPivot(data, curr_row, rows_count, columns_count, swaps_count)) {
+            continue;
+        }
+        std::vector<sptrObj> &pivot_line = data[curr_row];
+        if (mode_ & cmd::inv) { // make 1 leading
+            div = As<Evaluable>(pivot_line[curr_row]);
+            for (size_t j = 0; j < columns_count; ++j) {
+                pivot_line[j] = *As<Evaluable>(pivot_line[j]) / div;
+            }
+        }
+        div = As<Evaluable>(pivot_line[curr_row]);
         for (size_t i = mode_ == cmd::to_triangle ? curr_row + 1 : 0; i < rows_count; ++i) {
-            if (curr_row >= columns_count) {
+            if (i == curr_row || IsZero(data[i][curr_row])) {
                 continue;
             }
-            if (As<Rational>(data[curr_row][curr_row])->Numerator() == 0) {
-                bool non_zero_not_found = true;
-                for (size_t k = curr_row + 1; k < rows_count; ++k) {
-                    if (As<Rational>(data[k][curr_row])->Numerator() != 0) {
-                        std::swap(data[k], data[curr_row]);
-                        non_zero_not_found = false;
-                        break;
-                    }
-                }
-                if (non_zero_not_found) {
-                    continue;
-                }
-            }
-            div = As<Evaluable>(data[curr_row][curr_row]);
             mul_cf = *As<Evaluable>(data[i][curr_row]) / div;
-            for (size_t j = 0;
-                 j < columns_count; ++j) { // should run beginning from curr_row + 1 if want triang view
-                if (i == curr_row && (mode_ & cmd::inv)) { // should ignore, if want diag only
-                    data[i][j] = *As<Evaluable>(data[i][j]) / div; // make 1 leading
-                } else if (i != curr_row) {
-                    data[i][j] =
-                            *As<Evaluable>(data[i][j]) -
-                            (*As<Evaluable>(data[curr_row][j]) * mul_cf); // make zero all others
+            for (size_t j = 0; j < columns_count; ++j) { // make zero all others
+                if (!IsZero(pivot_line[j])) {
+                    data[i][j] = *As<Evaluable>(data[i][j]) - (*As<Evaluable>(pivot_line[j]) * mul_cf);
                 }
             }
         }
-        ++curr_row;
     }
+    return swaps_count;
+}
+
+sptrObj LinearTransformationCommand::FromLU(std::vector<std::vector<sptrObj>> &data,
+                                            const std::vector<size_t> &permutation, size_t swaps_count) const {
+    size_t size = data.size();
+    if (mode_ == cmd::inv) {
+        return std::make_shared<Matrix>(InverseFromLU(data, permutation));
+    }
+    if (mode_ == cmd::det) {
+        std::shared_ptr<Rational> determinant = std::make_shared<Rational>(swaps_count % 2 ? -1 : 1);
+        for (size_t i = 0; i < size; ++i) {
+            determinant = As<Rational>(*determinant * As<Evaluable>(data[i][i]));
+        }
+        return determinant;
+    }
+    // to_triangle: U is exactly what row by row forward elimination gives
+    sptrObj zero = std::make_shared<Rational>(0);
+    for (size_t i = 1; i < size; ++i) {
+        for (size_t j = 0; j < i; ++j) {
+            data[i][j] = zero;
+        }
+    }
+    return std::make_shared<Matrix>(std::move(data));
 }
 
-sptrObj LinearTransformationCommand::Run(std::list<sptrObj> &args) {
+sptrObj LinearTransformationCommand::Run(std::vector<sptrObj> &args) {
     if (args.size() != 1) {
         throw RuntimeError("LinearTransformationCommand::Run: expected 1 argument\n");
     }
     if (!Is<Matrix>(args.front())) {
         throw RuntimeError("LinearTransformationCommand::Run: expected matrix as argument\n");
     }
-    std::vector<std::vector<sptrObj>> data = As<Matrix>(args.front())->DeepCopy();
+    const Matrix &matrix = *As<Matrix>(args.front());
+    uint32_t cache_tag = mode_ << 2 | pivot_mode_; // result of to_diag and to_triangle depends on pivoting
+    if (sptrObj result = ResultCache::Instance().Find(cache_tag, matrix)) {
+        return result;
+    }
+    sptrObj result = Transform(matrix);
+    ResultCache::Instance().Insert(cache_tag, matrix, result);
+    return result;
+}
+
+sptrObj LinearTransformationCommand::Transform(const Matrix &matrix) const {
+    std::vector<std::vector<sptrObj>> data = matrix.DeepCopy();
     size_t rows_count = data.size(), columns_count = data[0].size();
-    if (mode_ == cmd::inv) {
-        if (rows_count != columns_count) {
-            throw RuntimeError("LinearTransformationCommand::Run: (inv) only square matrix can be inverse\n");
+    if (mode_ == cmd::inv && rows_count != columns_count) {
+        throw RuntimeError("LinearTransformationCommand::Run: (inv) only square matrix can be inverse\n");
+    } else if (mode_ == cmd::det && rows_count != columns_count) {
+        throw RuntimeError("LinearTransformationCommand::Run: (det) det is only for square matrices\n");
+    }
+    // only det, inv and to_triangle of big square matrices are read from LU: rref and to_diag eliminate over
+    // pivots too and rank swaps columns, so they are built row by row; singular matrix has no LU, but its
+    // to_triangle must still be built, so matrix is checked modulo prime before any LU work is done
+    if (rows_count == columns_count && rows_count > kBlockSize &&
+        (mode_ == cmd::det || mode_ == cmd::inv || (mode_ == cmd::to_triangle && IsNonsingularModPrime(data)))) {
+        std::vector<size_t> permutation;
+        size_t swaps_count = 0;
+        if (BlockLU(data, permutation, swaps_count, pivot_mode_)) {
+            return FromLU(data, permutation, swaps_count);
+        }
+        if (mode_ == cmd::det) {
+            return std::make_shared<Rational>(0);
         }
+        throw RuntimeError("LinearTransformationCommand::Run: inverse of matrix with det = 0 was requested\n");
+    }
+    if (mode_ == cmd::inv) {
         for (size_t i = 0; i < rows_count; ++i) {
             for (size_t j = 0; j < columns_count; ++j) {
                 data[i].push_back(std::make_shared<Rational>(i == j));
             }
         }
         columns_count <<= 1;
-    } else if (mode_ == cmd::det && rows_count != columns_count) {
-        throw RuntimeError("LinearTransformationCommand::Run: (det) det is only for square matrices\n");
     }
-    MakeTransform(data, rows_count, columns_count);
+    size_t swaps_count = MakeTransform(data, rows_count, columns_count);
     if (mode_ == cmd::rref) {
         return std::make_shared<Matrix>(std::move(data));
     }
@@ -124,7 +282,7 @@ sptrObj LinearTransformationCommand::Run(std::list<sptrObj> &args) {
         return std::make_shared<Matrix>(inv_result);
     }
     if (mode_ == cmd::det) {
-        std::shared_ptr<Rational> determinant = std::make_shared<Rational>(1);
+        std::shared_ptr<Rational> determinant = std::make_shared<Rational>(swaps_count % 2 ? -1 : 1);
         for (size_t i = 0; i < rows_count; ++i) {
             determinant = As<Rational>(*determinant * As<Evaluable>(data[i][i]));
         }
@@ -139,3 +297,117 @@ sptrObj LinearTransformationCommand::Run(std::list<sptrObj> &args) {
     }
     return std::make_shared<Rational>(rank);
 }
+
+
+CharPolyCommand::CharPolyCommand(cmd::PivotMode pivot_mode)
+        : BaseCommand(cmd::CharacteristicPolynomial),
+          pivot_mode_(pivot_mode) {}
+
+sptrObj CharPolyCommand::Run(std::vector<sptrObj> &args) {
+    if (args.size() != 1) {
+        throw RuntimeError("CharPolyCommand::Run: expected 1 argument\n");
+    }
+    if (!Is<Matrix>(args.front())) {
+        throw RuntimeError("CharPolyCommand::Run: expected matrix as argument\n");
+    }
+    std::vector<std::vector<sptrObj>> data = As<Matrix>(args.front())->DeepCopy();
+    size_t size = data.size();
+    if (size != data[0].size()) {
+        throw RuntimeError("CharPolyCommand::Run: characteristic polynomial is only for square matrices\n");
+    }
+    ReduceToHessenberg(data, pivot_mode_);
+    // p_m(x) = (x - h[m][m]) * p_{m-1}(x) - sum_i h[m-i][m] * h[m][m-1] * ... * h[m-i+1][m-i] * p_{m-i-1}(x),
+    // where h is Hessenberg matrix and p_m is characteristic polynomial of its leading m x m block
+    std::vector<std::shared_ptr<Polynomial>> leading{std::make_shared<Polynomial>(
+            std::vector<std::shared_ptr<Evaluable>>{std::make_shared<Rational>(1)})};
+    leading.reserve(size + 1);
+    for (size_t m = 0; m < size; ++m) {
+        std::shared_ptr<Polynomial> poly = leading[m]->MultiplyByLinear(As<Evaluable>(data[m][m]));
+        std::shared_ptr<Evaluable> product = std::make_shared<Rational>(1);
+        for (size_t i = 1; i <= m; ++i) {
+            product = *product * As<Evaluable>(data[m - i + 1][m - i]);
+            if (As<Rational>(product)->Numerator() == 0) {
+                break; // all next terms have zero subdiagonal factor too
+            }
+            poly = poly->SubtractScaled(*leading[m - i], *As<Evaluable>(data[m - i][m]) * product);
+        }
+        leading.push_back(poly);
+    }
+    return leading.back();
+}
+
+CostEstimate CharPolyCommand::Estimate(const std::vector<CostEstimate> &args) const {
+    if (args.size() != 1) {
+        return {0, 0, 1};
+    }
+    // reduction to Hessenberg form and recurrence over its leading blocks
+    return {0, 0, 2 * std::pow(double(args.front().lines), 3) + 1};
+}
+
+PolyEvalCommand::PolyEvalCommand()
+        : BaseCommand(cmd::PolynomialEvaluation) {}
+
+sptrObj PolyEvalCommand::Run(std::vector<sptrObj> &args) {
+    if (args.size() != 2) {
+        throw RuntimeError("PolyEvalCommand::Run: expected 2 arguments (polynomial and point)\n");
+    }
+    if (!Is<Polynomial>(args.front()) || !Is<Rational>(args.back())) {
+        throw RuntimeError("PolyEvalCommand::Run: polynomial and rational point were expected\n");
+    }
+    return As<Polynomial>(args.front())->Evaluate(As<Evaluable>(args.back()));
+}
+
+LoadCommand::LoadCommand(std::string root)
+        : BaseCommand(cmd::Load),
+          root_(std::move(root)) {}
+
+sptrObj LoadCommand::Run(std::vector<sptrObj> &args) {
+    if (args.size() != 1 || !Is<StringObject>(args.front())) {
+        throw RuntimeError("LoadCommand::Run: path to file was expected\n");
+    }
+    return io::LoadMatrix(io::ResolvePath(root_, As<StringObject>(args.front())->GetValue()));
+}
+
+SaveCommand::SaveCommand(std::string root)
+        : BaseCommand(cmd::Save),
+          root_(std::move(root)) {}
+
+sptrObj SaveCommand::Run(std::vector<sptrObj> &args) {
+    if (args.size() != 2 || !Is<Matrix>(args.front()) || !Is<StringObject>(args.back())) {
+        throw RuntimeError("SaveCommand::Run: matrix and path to file were expected\n");
+    }
+    io::SaveMatrix(*As<Matrix>(args.front()), io::ResolvePath(root_, As<StringObject>(args.back())->GetValue()));
+    return std::make_shared<NoneObject>();
+}
+
+CostEstimate SaveCommand::Estimate(const std::vector<CostEstimate> &args) const {
+    if (args.empty()) {
+        return {0, 0, 1};
+    }
+    return {0, 0, double(args.front().lines) * args.front().columns + 1};
+}
+
+WorkspaceCommand::WorkspaceCommand(Dispatcher &workspace, bool is_restore, std::string root)
+        : BaseCommand(cmd::Workspace),
+          workspace_(workspace),
+          is_restore_(is_restore),
+          root_(std::move(root)) {}
+
+sptrObj WorkspaceCommand::Run(std::vector<sptrObj> &args) {
+    if (args.size() != 1 || !Is<StringObject>(args.front())) {
+        throw RuntimeError("WorkspaceCommand::Run: path to file was expected\n");
+    }
+    std::string path = io::ResolvePath(root_, As<StringObject>(args.front())->GetValue());
+    if (is_restore_) {
+        for (auto &[name, value]: io::LoadWorkspace(path)) {
+            workspace_.InitObject(name, std::move(value));
+        }
+    } else {
+        io::Variables variables;
+        for (auto &[id, value]: workspace_.Variables()) {
+            variables.emplace_back(workspace_.Name(id), std::move(value));
+        }
+        io::SaveWorkspace(variables, path);
+    }
+    return std::make_shared<NoneObject>();
+}
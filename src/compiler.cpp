@@ -0,0 +1,399 @@
+#include "compiler.h"
+
+#include <algorithm>
+
+
+Compiler::Compiler(Dispatcher &dispatcher) : dispatcher_(dispatcher) {}
+
+void Compiler::SetExports(std::optional<std::set<std::string>> exports) {
+    exports_ = std::move(exports);
+}
+
+uint32_t Compiler::SymbolId(const sptrObj &symbol) {
+    return dispatcher_.Intern(As<Symbol>(symbol)->GetName());
+}
+
+uint32_t Compiler::VariableSlot(uint32_t id) {
+    auto [it, inserted] = variable_slots_.try_emplace(id, program_.variables.size());
+    if (inserted) {
+        program_.variables.push_back(id);
+        is_stored_.push_back(false);
+        versions_.push_back(0);
+    }
+    return it->second;
+}
+
+uint32_t Compiler::CommandSlot(uint32_t id) {
+    auto [it, inserted] = command_slots_.try_emplace(id, program_.commands.size());
+    if (inserted) {
+        program_.command_ids.push_back(id);
+        program_.commands.push_back(dispatcher_.Find(id));
+    }
+    return it->second;
+}
+
+uint32_t Compiler::Constant(sptrObj value) {
+    program_.constants.push_back(std::move(value));
+    return program_.constants.size() - 1;
+}
+
+uint32_t Compiler::Emit(bc::op_code op, uint32_t operand, const std::vector<uint32_t> &args) {
+    // same pure instruction on same registers gives same value, so it is computed only once
+    std::vector<uint32_t> key;
+    if (op == bc::LoadVar ||
+        op == bc::MakeMatrix ||
+        (op == bc::Call && program_.commands[operand] && program_.commands[operand]->IsPure())) {
+        key.reserve(args.size() + 2);
+        key.push_back(op);
+        key.push_back(operand);
+        if (op == bc::LoadVar) {
+            key.push_back(versions_[operand]);
+        }
+        key.insert(key.end(), args.begin(), args.end());
+        if (auto it = value_numbers_.find(key); it != value_numbers_.end()) {
+            return it->second;
+        }
+    }
+    uint32_t dst = op == bc::Store ? 0 : program_.registers_count++;
+    program_.code.push_back({op, dst, operand, static_cast<uint32_t>(program_.args.size()),
+                             static_cast<uint32_t>(args.size()), statement_});
+    program_.args.insert(program_.args.end(), args.begin(), args.end());
+    if (!key.empty()) {
+        value_numbers_.emplace(std::move(key), dst);
+    }
+    return dst;
+}
+
+void Compiler::RemoveDeadCode() {
+    // backward liveness: instruction is needed if it has side effect or its result is read by needed one
+    std::vector<bool> is_live_register(program_.registers_count, false);
+    std::vector<bool> is_live_slot(program_.variables.size()); // value of slot is read later
+    for (size_t slot = 0; slot < program_.variables.size(); ++slot) {
+        is_live_slot[slot] = !exports_ || exports_->contains(dispatcher_.Name(program_.variables[slot]));
+    }
+    std::vector<bool> is_read(program_.registers_count, false);
+    for (uint32_t arg: program_.args) {
+        is_read[arg] = true;
+    }
+    std::vector<bool> is_live(program_.code.size(), false);
+    for (size_t i = program_.code.size(); i-- > 0;) {
+        const Instruction &instruction = program_.code[i];
+        switch (instruction.op) {
+            case bc::Store:
+                is_live[i] = is_live_slot[instruction.operand];
+                is_live_slot[instruction.operand] = false; // older value is overwritten here
+                break;
+            case bc::LoadVar:
+                is_live[i] = is_live_register[instruction.dst];
+                is_live_slot[instruction.operand] = is_live_slot[instruction.operand] || is_live[i];
+                break;
+            case bc::Call: {
+                const auto &command = program_.commands[instruction.operand];
+                // unknown command may have side effect, so it is kept to report error if it is a statement of its
+                // own; inside binding nothing reads it is dropped with the binding like any other error there
+                is_live[i] = is_live_register[instruction.dst] || (command && !command->IsPure()) ||
+                             (!command && !is_read[instruction.dst]);
+                break;
+            }
+            default:
+                is_live[i] = is_live_register[instruction.dst];
+        }
+        if (is_live[i]) {
+            for (uint32_t k = 0; k < instruction.args_count; ++k) {
+                is_live_register[program_.args[instruction.args_begin + k]] = true;
+            }
+        }
+    }
+    std::vector<Instruction> code;
+    std::vector<uint32_t> args;
+    std::set<uint32_t> loaded_slots;
+    for (size_t i = 0; i < program_.code.size(); ++i) {
+        if (!is_live[i]) {
+            continue;
+        }
+        Instruction instruction = program_.code[i];
+        args.insert(args.end(), program_.args.begin() + instruction.args_begin,
+                    program_.args.begin() + instruction.args_begin + instruction.args_count);
+        instruction.args_begin = args.size() - instruction.args_count;
+        if (instruction.op == bc::LoadVar) {
+            loaded_slots.insert(instruction.operand);
+        }
+        code.push_back(instruction);
+    }
+    program_.code = std::move(code);
+    program_.args = std::move(args);
+    std::erase_if(program_.parameters, [&](uint32_t slot) { return !loaded_slots.contains(slot); });
+}
+
+void Compiler::FoldConstants() {
+    // pure calls and matrices on values known before execution are computed now; dead code is already removed,
+    // so nothing is computed for bindings which are never used
+    std::vector<sptrObj> known_values(program_.registers_count);
+    std::vector<sptrObj> values;
+    for (Instruction &instruction: program_.code) {
+        if (instruction.op == bc::LoadConst) {
+            known_values[instruction.dst] = program_.constants[instruction.operand];
+            continue;
+        }
+        const auto &command = instruction.op == bc::Call ? program_.commands[instruction.operand] : nullptr;
+        bool is_known = (command && command->IsPure()) || instruction.op == bc::MakeMatrix;
+        values.clear();
+        for (uint32_t k = 0; k < instruction.args_count && is_known; ++k) {
+            values.push_back(known_values[program_.args[instruction.args_begin + k]]);
+            is_known = instruction.op == bc::MakeMatrix ? Is<Rational>(values.back()) : values.back() != nullptr;
+        }
+        if (!is_known) {
+            continue;
+        }
+        sptrObj value;
+        if (instruction.op == bc::MakeMatrix) { // cells are constant expressions like 2 * (3 - 1)
+            size_t lines = instruction.operand, columns = instruction.args_count / lines;
+            std::vector<std::vector<sptrObj>> cells(lines);
+            for (size_t curr_l = 0; curr_l < lines; ++curr_l) {
+                cells[curr_l].assign(values.begin() + curr_l * columns, values.begin() + (curr_l + 1) * columns);
+            }
+            value = std::make_shared<Matrix>(std::move(cells));
+        } else {
+            try {
+                value = Materialize(dispatcher_.Call(command, values));
+            } catch (const std::exception &) {
+                continue; // left for execution, so that error is raised in its turn
+            }
+        }
+        known_values[instruction.dst] = value;
+        instruction.op = bc::LoadConst;
+        instruction.operand = Constant(std::move(value));
+        instruction.args_count = 0;
+    }
+}
+
+void Compiler::RemoveUnusedConstants() {
+    // folded calls leave loads of their arguments behind
+    std::vector<bool> is_used(program_.registers_count, false);
+    for (const Instruction &instruction: program_.code) {
+        for (uint32_t k = 0; k < instruction.args_count; ++k) {
+            is_used[program_.args[instruction.args_begin + k]] = true;
+        }
+    }
+    std::vector<uint32_t> new_index(program_.constants.size(), 0);
+    std::vector<sptrObj> constants;
+    std::vector<Instruction> code;
+    code.reserve(program_.code.size());
+    for (Instruction instruction: program_.code) {
+        if (instruction.op == bc::LoadConst) {
+            if (!is_used[instruction.dst]) {
+                continue;
+            }
+            new_index[instruction.operand] = constants.size();
+            constants.push_back(std::move(program_.constants[instruction.operand]));
+            instruction.operand = new_index[instruction.operand];
+        }
+        code.push_back(instruction);
+    }
+    program_.code = std::move(code);
+    program_.constants = std::move(constants);
+}
+
+void Compiler::BuildStatements() {
+    // statement waits for ones computing registers and slots it reads, for earlier readers and writers of slots
+    // it writes; statement with side effect (print, unknown command) waits for everything before it
+    constexpr uint32_t kNone = UINT32_MAX;
+    std::vector<uint32_t> register_owner(program_.registers_count, kNone);
+    std::vector<bool> is_shared(program_.registers_count, false);
+    std::vector<uint32_t> last_store(program_.variables.size(), kNone);
+    std::vector<std::vector<uint32_t>> readers(program_.variables.size()); // of slot since its last store
+    uint32_t last_barrier = kNone; // last statement with side effect
+    std::set<uint32_t> dependencies;
+    bool has_side_effect = false;
+    auto finish = [&](uint32_t code_end) {
+        Statement &statement = program_.statements.back();
+        uint32_t index = program_.statements.size() - 1;
+        statement.code_end = code_end;
+        if (has_side_effect) { // statements before last barrier are already waited for by it
+            for (uint32_t other = last_barrier == kNone ? 0 : last_barrier; other < index; ++other) {
+                dependencies.insert(other);
+            }
+            last_barrier = index;
+        }
+        statement.dependencies.assign(dependencies.begin(), dependencies.end());
+        dependencies.clear();
+        has_side_effect = false;
+    };
+    for (uint32_t i = 0; i < program_.code.size(); ++i) {
+        const Instruction &instruction = program_.code[i];
+        if (i == 0 || instruction.statement != program_.code[i - 1].statement) {
+            if (i != 0) {
+                finish(i);
+            }
+            program_.statements.push_back({i, i, {}, {}});
+        }
+        uint32_t index = program_.statements.size() - 1;
+        for (uint32_t k = 0; k < instruction.args_count; ++k) {
+            uint32_t arg = program_.args[instruction.args_begin + k];
+            if (register_owner[arg] != index) {
+                dependencies.insert(register_owner[arg]);
+                if (!is_shared[arg]) {
+                    is_shared[arg] = true;
+                    program_.statements[register_owner[arg]].shared.push_back(arg);
+                }
+            }
+        }
+        switch (instruction.op) {
+            case bc::LoadVar:
+                if (last_store[instruction.operand] != kNone && last_store[instruction.operand] != index) {
+                    dependencies.insert(last_store[instruction.operand]);
+                }
+                readers[instruction.operand].push_back(index);
+                break;
+            case bc::Store:
+                for (uint32_t reader: readers[instruction.operand]) {
+                    if (reader != index) {
+                        dependencies.insert(reader);
+                    }
+                }
+                if (last_store[instruction.operand] != kNone && last_store[instruction.operand] != index) {
+                    dependencies.insert(last_store[instruction.operand]);
+                }
+                readers[instruction.operand].clear();
+                last_store[instruction.operand] = index;
+                break;
+            case bc::Call: {
+                const auto &command = program_.commands[instruction.operand];
+                has_side_effect = has_side_effect || !command || !command->IsPure();
+                break;
+            }
+            default:
+                break;
+        }
+        if (instruction.op != bc::Store) {
+            register_owner[instruction.dst] = index;
+        }
+    }
+    if (!program_.code.empty()) {
+        finish(program_.code.size());
+    }
+}
+
+void Compiler::CompileStatement(const sptrObj &object) {
+    if (!Is<CommandObject>(object)) {
+        throw SyntaxError("Interpreter: unknown type was given\n");
+    }
+    std::shared_ptr<CommandObject> command = As<CommandObject>(object);
+    if (!Is<Symbol>(command->GetCommand())) {
+        throw SyntaxError("Interpreter: invalid command name\n");
+    }
+    if (As<Symbol>(command->GetCommand())->GetName() == "init") {
+        std::list<sptrObj> &args = command->GetArgs();
+        if (args.size() != 2 || !Is<Symbol>(args.front())) {
+            throw RuntimeError("Dispatcher: invalid arguments were provided for initialization\n");
+        }
+        uint32_t value = CompileObject(args.back());
+        uint32_t id = SymbolId(args.front());
+        dispatcher_.ValidateName(id); // store itself may be never executed
+        uint32_t slot = VariableSlot(id);
+        Emit(bc::Store, slot, {value});
+        is_stored_[slot] = true;
+        // loads of the variable issued before are outdated, ones issued after read the stored register
+        value_numbers_[{bc::LoadVar, slot, ++versions_[slot]}] = value;
+        return;
+    }
+    if (IsWorkspaceCall(command)) { // interpreter runs it as separate program, after statements before it
+        std::vector<uint32_t> args;
+        for (const auto &arg: command->GetArgs()) {
+            args.push_back(CompileObject(arg));
+        }
+        Emit(bc::Call, CommandSlot(SymbolId(command->GetCommand())), args);
+        return;
+    }
+    CompileObject(object);
+}
+
+bool Compiler::IsWorkspaceCall(const std::shared_ptr<CommandObject> &command) const {
+    if (!Is<Symbol>(command->GetCommand())) {
+        return false;
+    }
+    std::shared_ptr<BaseCommand> function = dispatcher_.Find(As<Symbol>(command->GetCommand())->GetName());
+    return function && function->GetType() == cmd::Workspace;
+}
+
+uint32_t Compiler::CompileObject(const sptrObj &object) {
+    if (Is<CommandObject>(object)) {
+        std::shared_ptr<CommandObject> command = As<CommandObject>(object);
+        if (!Is<Symbol>(command->GetCommand())) {
+            throw SyntaxError("Interpreter: invalid command name\n");
+        }
+        if (IsWorkspaceCall(command)) { // it would see workspace before statements around it
+            throw SyntaxError("Compiler: snapshot and restore can be used only as separate statements\n");
+        }
+        std::vector<uint32_t> args;
+        for (const auto &arg: command->GetArgs()) {
+            args.push_back(CompileObject(arg));
+        }
+        return Emit(bc::Call, CommandSlot(SymbolId(command->GetCommand())), args);
+    } else if (Is<Matrix>(object)) {
+        return CompileMatrix(As<Matrix>(object));
+    } else if (Is<Expression>(object)) {
+        return CompileExpression(As<Expression>(object));
+    } else if (Is<Rational>(object) || Is<StringObject>(object)) {
+        return Emit(bc::LoadConst, Constant(object));
+    } else if (Is<Symbol>(object)) {
+        uint32_t symbol = SymbolId(object);
+        if (dispatcher_.IsRegisteredSymbol(symbol)) {
+            return Emit(bc::LoadConst, Constant(object));
+        }
+        uint32_t slot = VariableSlot(symbol);
+        if (!is_stored_[slot] &&
+            std::find(program_.parameters.begin(), program_.parameters.end(), slot) == program_.parameters.end()) {
+            program_.parameters.push_back(slot);
+        }
+        return Emit(bc::LoadVar, slot);
+    }
+    throw SyntaxError("Interpreter: unknown type was given\n");
+}
+
+uint32_t Compiler::CompileExpression(const std::shared_ptr<Expression> &expression) {
+    const std::vector<sptrObj> &operands = expression->GetOperands();
+    if (expression->GetOperation() == expr::Neg) { // -x == -1 * x
+        uint32_t minus_one = Emit(bc::LoadConst, Constant(std::make_shared<Rational>(-1)));
+        return Emit(bc::Call, CommandSlot(SymbolTable::Instance().Intern("*")), {minus_one, CompileObject(operands.front())});
+    }
+    uint32_t lhs = CompileObject(operands.front());
+    uint32_t rhs = CompileObject(operands.back());
+    return Emit(bc::Call, CommandSlot(SymbolTable::Instance().Intern(Expression::OperationName(expression->GetOperation()))), {lhs, rhs});
+}
+
+uint32_t Compiler::CompileMatrix(const std::shared_ptr<Matrix> &matrix) {
+    auto [lines, columns] = matrix->size();
+    bool is_constant = true;
+    for (const auto &cell: *matrix) {
+        is_constant = is_constant && Is<Rational>(cell);
+    }
+    if (is_constant) {
+        return Emit(bc::LoadConst, Constant(std::make_shared<Matrix>(matrix->GetArray())));
+    }
+    std::vector<uint32_t> cells;
+    cells.reserve(lines * columns);
+    for (const auto &cell: *matrix) {
+        cells.push_back(CompileObject(cell));
+    }
+    return Emit(bc::MakeMatrix, lines, cells);
+}
+
+Program Compiler::Compile(const std::list<sptrObj> &script) {
+    program_ = Program{};
+    variable_slots_.clear();
+    command_slots_.clear();
+    is_stored_.clear();
+    versions_.clear();
+    value_numbers_.clear();
+    statement_ = 0;
+    for (const auto &statement: script) {
+        CompileStatement(statement);
+        ++statement_;
+    }
+    RemoveDeadCode();
+    FoldConstants();
+    RemoveUnusedConstants();
+    BuildStatements();
+    return std::move(program_);
+}
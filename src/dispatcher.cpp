@@ -1,140 +1,270 @@
 #include "dispatcher.h"
 
+#include <algorithm>
+#include <cmath>
+#include <optional>
 #include <utility>
 
 
-Dispatcher::Dispatcher() {
-    registers_ = {
-            {"+",           std::make_shared<ArithmeticCommand>(
-                    [&](const sptrObj &lhs, const sptrObj &rhs) -> sptrObj {
-                        if (Is<Matrix>(lhs)) {
-                            return *As<Matrix>(lhs) + As<Evaluable>(rhs);
-                        } else if (Is<Rational>(lhs) && Is<Rational>(rhs)) {
-                            return *As<Rational>(lhs) + As<Evaluable>(rhs);
-                        }
-                        throw RuntimeError("Dispatcher: invalid operands for summation\n");
-                    })},
-            {"-",           std::make_shared<ArithmeticCommand>(
-                    [&](const sptrObj &lhs, const sptrObj &rhs) -> sptrObj {
-                        if (Is<Matrix>(lhs) && Is<Matrix>(rhs)) {
-                            return *As<Matrix>(lhs) - As<Evaluable>(rhs);
-                        } else if (Is<Rational>(lhs) && Is<Rational>(rhs)) {
-                            return *As<Rational>(lhs) - As<Evaluable>(rhs);
-                        }
-                        throw RuntimeError("Dispatcher: invalid operands for subtraction\n");
-                    })},
-            {"*",           std::make_shared<ArithmeticCommand>(
-                    [&](const sptrObj &lhs, const sptrObj &rhs) -> sptrObj {
-                        if (Is<Rational>(lhs) && Is<Rational>(rhs)) {
-                            return *As<Rational>(lhs) * As<Evaluable>(rhs);
-                        } else if (Is<Matrix>(lhs)) {
-                            return *As<Matrix>(lhs) * As<Evaluable>(rhs);
-                        } else if (Is<Rational>(lhs) && Is<Matrix>(rhs)) {
-                            return *As<Matrix>(rhs) * As<Evaluable>(lhs);
-                        }
-                        throw RuntimeError("Dispatcher: invalid operands for multiply\n");
-                    })},
-            {"/",           std::make_shared<ArithmeticCommand>(
-                    [&](const sptrObj &lhs, const sptrObj &rhs) -> sptrObj {
-                        if (Is<Rational>(lhs) && Is<Rational>(rhs)) {
-                            return *As<Rational>(lhs) / As<Evaluable>(rhs);
-                        } else if (Is<Matrix>(lhs)) {
-                            return *As<Matrix>(lhs) / As<Evaluable>(rhs);
-                        }
-                        throw RuntimeError("Dispatcher: invalid operands for division\n");
-                    })},
-            {"transpose",   std::make_shared<TransposeCommand>()},
-            {"rref",        std::make_shared<LinearTransformationCommand>(cmd::rref)},
-            {"to_diag",     std::make_shared<LinearTransformationCommand>(cmd::to_diag)},
-            {"to_triangle", std::make_shared<LinearTransformationCommand>(cmd::to_triangle)},
-            {"inv",         std::make_shared<LinearTransformationCommand>(cmd::inv)},
-            {"det",         std::make_shared<LinearTransformationCommand>(cmd::det)},
-            {"rank",        std::make_shared<LinearTransformationCommand>(cmd::rank)},
-    };
-}
-
-
-bool Dispatcher::IsArithmeticOperation(const std::shared_ptr<Object> &sptr) {
-    if (!Is<Symbol>(sptr)) {
-        return false;
-    }
-    std::string value = As<Symbol>(sptr)->GetString();
-    return value == "+" || value == "-" || value == "*" || value == "/";
-}
-
-Dispatcher &Dispatcher::Instance() {
-    if (!instance) {
-        instance = new Dispatcher{};
-        deleter.Init(instance);
-    }
-    return *instance;
-}
-
-bool Dispatcher::IsRegisteredSymbol(const std::string &regname) {
-    return instance->registers_.contains(regname) || regname == ")" || regname == "(";
+namespace {
+    // operands of these functions are already checked by ArithmeticCommand table
+    sptrObj AddRationals(const sptrObj &lhs, const sptrObj &rhs) {
+        return *As<Rational>(lhs) + As<Evaluable>(rhs);
+    }
+
+    sptrObj AddMatrices(const sptrObj &lhs, const sptrObj &rhs) {
+        return *LazyMatrix::Of(lhs) + As<Evaluable>(rhs);
+    }
+
+    sptrObj SubtractRationals(const sptrObj &lhs, const sptrObj &rhs) {
+        return *As<Rational>(lhs) - As<Evaluable>(rhs);
+    }
+
+    sptrObj SubtractMatrices(const sptrObj &lhs, const sptrObj &rhs) {
+        return *LazyMatrix::Of(lhs) - As<Evaluable>(rhs);
+    }
+
+    sptrObj MultiplyRationals(const sptrObj &lhs, const sptrObj &rhs) {
+        return *As<Rational>(lhs) * As<Evaluable>(rhs);
+    }
+
+    sptrObj MultiplyMatrix(const sptrObj &lhs, const sptrObj &rhs) { // by matrix or scalar
+        return *LazyMatrix::Of(lhs) * As<Evaluable>(rhs);
+    }
+
+    sptrObj MultiplyScalar(const sptrObj &lhs, const sptrObj &rhs) { // by matrix
+        return *LazyMatrix::Of(rhs) * As<Evaluable>(lhs);
+    }
+
+    sptrObj DivideRationals(const sptrObj &lhs, const sptrObj &rhs) {
+        return *As<Rational>(lhs) / As<Evaluable>(rhs);
+    }
+
+    sptrObj DivideMatrix(const sptrObj &lhs, const sptrObj &rhs) {
+        return *LazyMatrix::Of(lhs) / As<Evaluable>(rhs);
+    }
+
+    int64_t IntegerExponent(const sptrObj &rhs) {
+        if (As<Rational>(rhs)->Denominator() != 1) {
+            throw RuntimeError("Dispatcher: power exponent must be an integer\n");
+        }
+        return As<Rational>(rhs)->Numerator();
+    }
+
+    sptrObj PowerRational(const sptrObj &lhs, const sptrObj &rhs) {
+        int64_t exponent = IntegerExponent(rhs);
+        if (exponent < 0 && As<Rational>(lhs)->Numerator() == 0) {
+            throw RuntimeError("Dispatcher: zero can't be raised to negative power\n");
+        }
+        std::shared_ptr<Evaluable> result = std::make_shared<Rational>(1), base = As<Rational>(lhs);
+        for (uint64_t n = exponent < 0 ? -static_cast<uint64_t>(exponent) : exponent; n; n >>= 1) {
+            if (n & 1) {
+                result = *As<Rational>(result) * base;
+            }
+            if (n > 1) {
+                base = *As<Rational>(base) * base;
+            }
+        }
+        return exponent < 0 ? Rational(1) / result : result;
+    }
+
+    sptrObj PowerMatrix(const sptrObj &lhs, const sptrObj &rhs) {
+        int64_t exponent = IntegerExponent(rhs);
+        if (exponent < 0) {
+            throw RuntimeError("Dispatcher: negative power of matrix, use inv instead\n");
+        }
+        return Matrix::Power(*As<Matrix>(Materialize(lhs)), exponent);
+    }
+
+    // operation applied to each cell of matrix operand, if any
+    CostEstimate ElementwiseCost(const CostEstimate &lhs, const CostEstimate &rhs) {
+        const CostEstimate &shape = lhs.lines ? lhs : rhs;
+        return {shape.lines, shape.columns, double(shape.lines) * shape.columns + 1};
+    }
+
+    CostEstimate ProductCost(const CostEstimate &lhs, const CostEstimate &rhs) {
+        if (!lhs.lines || !rhs.lines) {
+            return ElementwiseCost(lhs, rhs);
+        }
+        return {lhs.lines, rhs.columns, double(lhs.lines) * lhs.columns * rhs.columns + 1};
+    }
+
+    CostEstimate PowerCost(const CostEstimate &lhs, const CostEstimate &) {
+        // exponent is unknown, so it is taken as a few squarings
+        return {lhs.lines, lhs.columns, 8 * std::pow(double(lhs.lines), 3) + 1};
+    }
+
+    std::vector<std::shared_ptr<BaseCommand>> MakeStandardCommands() {
+        std::vector<std::shared_ptr<BaseCommand>> registers;
+        using enum object_type;
+        std::pair<std::string, std::shared_ptr<BaseCommand>> standard[] = {
+                {"+",           std::make_shared<ArithmeticCommand>(std::initializer_list<ArithmeticCommand::Rule>{
+                        {RationalT,   RationalT,   AddRationals},
+                        {MatrixT,     MatrixT,     AddMatrices},
+                        {MatrixT,     LazyMatrixT, AddMatrices},
+                        {LazyMatrixT, MatrixT,     AddMatrices},
+                        {LazyMatrixT, LazyMatrixT, AddMatrices},
+                }, "Dispatcher: invalid operands for summation\n", ElementwiseCost)},
+                {"-",           std::make_shared<ArithmeticCommand>(std::initializer_list<ArithmeticCommand::Rule>{
+                        {RationalT,   RationalT,   SubtractRationals},
+                        {MatrixT,     MatrixT,     SubtractMatrices},
+                        {MatrixT,     LazyMatrixT, SubtractMatrices},
+                        {LazyMatrixT, MatrixT,     SubtractMatrices},
+                        {LazyMatrixT, LazyMatrixT, SubtractMatrices},
+                }, "Dispatcher: invalid operands for subtraction\n", ElementwiseCost)},
+                {"*",           std::make_shared<ArithmeticCommand>(std::initializer_list<ArithmeticCommand::Rule>{
+                        {RationalT,   RationalT,   MultiplyRationals},
+                        {MatrixT,     RationalT,   MultiplyMatrix},
+                        {LazyMatrixT, RationalT,   MultiplyMatrix},
+                        {MatrixT,     MatrixT,     MultiplyMatrix},
+                        {MatrixT,     LazyMatrixT, MultiplyMatrix},
+                        {LazyMatrixT, MatrixT,     MultiplyMatrix},
+                        {LazyMatrixT, LazyMatrixT, MultiplyMatrix},
+                        {RationalT,   MatrixT,     MultiplyScalar},
+                        {RationalT,   LazyMatrixT, MultiplyScalar},
+                }, "Dispatcher: invalid operands for multiply\n", ProductCost)},
+                {"/",           std::make_shared<ArithmeticCommand>(std::initializer_list<ArithmeticCommand::Rule>{
+                        {RationalT,   RationalT,   DivideRationals},
+                        {MatrixT,     RationalT,   DivideMatrix},
+                        {LazyMatrixT, RationalT,   DivideMatrix},
+                }, "Dispatcher: invalid operands for division\n", ElementwiseCost)},
+                {"^",           std::make_shared<ArithmeticCommand>(std::initializer_list<ArithmeticCommand::Rule>{
+                        {RationalT,   RationalT,   PowerRational},
+                        {MatrixT,     RationalT,   PowerMatrix},
+                        {LazyMatrixT, RationalT,   PowerMatrix},
+                }, "Dispatcher: invalid operands for power\n", PowerCost)},
+                {"transpose",   std::make_shared<TransposeCommand>()},
+                {"rref",        std::make_shared<LinearTransformationCommand>(cmd::rref)},
+                {"to_diag",     std::make_shared<LinearTransformationCommand>(cmd::to_diag)},
+                {"to_triangle", std::make_shared<LinearTransformationCommand>(cmd::to_triangle)},
+                {"inv",         std::make_shared<LinearTransformationCommand>(cmd::inv)},
+                {"det",         std::make_shared<LinearTransformationCommand>(cmd::det)},
+                {"rank",        std::make_shared<LinearTransformationCommand>(cmd::rank, cmd::complete)},
+                {"charpoly",    std::make_shared<CharPolyCommand>()},
+                {"eval",        std::make_shared<PolyEvalCommand>()},
+                {"load",        std::make_shared<LoadCommand>()},
+                {"save",        std::make_shared<SaveCommand>()},
+        };
+        for (auto &[name, command]: standard) {
+            uint32_t id = SymbolTable::Instance().Intern(name);
+            registers.resize(std::max<size_t>(registers.size(), id + 1));
+            registers[id] = std::move(command);
+        }
+        return registers;
+    }
 }
 
-std::shared_ptr<Object> Dispatcher::At(const std::string &varname) const {
-    if (!instance->variables_.contains(varname)) {
-        return nullptr;
+const std::vector<std::shared_ptr<BaseCommand>> &Dispatcher::StandardCommands() {
+    static const std::vector<std::shared_ptr<BaseCommand>> registers = MakeStandardCommands();
+    return registers;
+}
+
+Dispatcher::Dispatcher() : registers_(StandardCommands()) {}
+
+
+uint32_t Dispatcher::Intern(std::string_view name) {
+    if (std::optional<uint32_t> id = SymbolTable::Instance().Find(name)) { // command
+        return *id;
     }
-    return instance->variables_.at(varname);
+    return kOwnSymbol | symbols_.Intern(name);
 }
 
-void Dispatcher::InitObject(const std::string &varname, std::shared_ptr<Object> sptr) {
-    if (instance->registers_.contains(varname)) {
+std::optional<uint32_t> Dispatcher::FindSymbol(std::string_view name) const {
+    if (std::optional<uint32_t> id = SymbolTable::Instance().Find(name)) {
+        return id;
+    }
+    if (std::optional<uint32_t> id = symbols_.Find(name)) {
+        return kOwnSymbol | *id;
+    }
+    return std::nullopt;
+}
+
+const std::string &Dispatcher::Name(uint32_t id) const {
+    return id & kOwnSymbol ? symbols_.Name(id & ~kOwnSymbol) : SymbolTable::Instance().Name(id);
+}
+
+
+bool Dispatcher::IsRegisteredSymbol(uint32_t id) const {
+    return id < registers_.size() && registers_[id];
+}
+
+std::shared_ptr<Object> Dispatcher::At(uint32_t id) const {
+    auto it = variables_.find(id);
+    return it != variables_.end() ? it->second : nullptr;
+}
+
+std::shared_ptr<Object> Dispatcher::At(const std::string &varname) const {
+    std::optional<uint32_t> id = FindSymbol(varname);
+    return id ? At(*id) : nullptr;
+}
+
+void Dispatcher::ValidateName(uint32_t id) const {
+    if (IsRegisteredSymbol(id)) {
         throw NameError("Dispatcher: invalid name for object initializing (this string is reserved by language)\n");
     }
+    const std::string &varname = Name(id);
     if (varname == "let" || varname == "init") {
         throw NameError("Dispatcher: don't laugh at me =(\n");
     }
-    instance->variables_[varname] = std::move(sptr);
-}
-
-std::shared_ptr<Object> Dispatcher::Eval(std::list<std::shared_ptr<Object>> &args) {
-    std::stack<std::shared_ptr<Object>> stack;
-    for (auto &arg: args) {
-        if (IsArithmeticOperation(arg)) {
-            std::shared_ptr<Object> value_1 = stack.top();
-            stack.pop();
-            std::shared_ptr<Object> value_2 = stack.top();
-            stack.pop();
-            std::list<std::shared_ptr<Object>> args_list{value_2, value_1};
-            stack.push(Invoke(As<Symbol>(arg)->GetString(), args_list));
-        } else {
-            stack.push(arg);
-        }
-    }
-    return stack.top();
 }
 
-std::shared_ptr<Object> Dispatcher::Invoke(const std::string &command, std::list<std::shared_ptr<Object>> &args) {
-    if (command == "init") {
-        if (args.size() != 2) {
-            throw RuntimeError("Dispatcher: invalid arguments were provided for initialization\n");
+std::vector<std::pair<uint32_t, std::shared_ptr<Object>>> Dispatcher::Variables() const {
+    std::vector<std::pair<uint32_t, std::shared_ptr<Object>>> variables;
+    for (const auto &[id, value]: variables_) {
+        if (value) {
+            variables.emplace_back(id, value);
         }
-        InitObject(As<Symbol>(args.front())->GetString(), args.back());
-        return instance->variables_.at(As<Symbol>(args.front())->GetString());
-    }
-    if (!instance->registers_.contains(command)) {
-        throw NameError("Dispatcher: function not found\n");
     }
-    return instance->registers_.at(command)->Run(args);
+    std::sort(variables.begin(), variables.end(), [](const auto &lhs, const auto &rhs) {
+        return lhs.first < rhs.first;
+    });
+    return variables;
 }
 
-void Dispatcher::SetCommand(const std::string& name, std::shared_ptr<BaseCommand> command) {
-    instance->registers_[name] = std::move(command);
+void Dispatcher::InitObject(uint32_t id, std::shared_ptr<Object> sptr) {
+    ValidateName(id);
+    variables_[id] = std::move(sptr);
 }
 
-Dispatcher *Dispatcher::instance = nullptr;
-Deleter Dispatcher::deleter;
+void Dispatcher::InitObject(const std::string &varname, std::shared_ptr<Object> sptr) {
+    InitObject(Intern(varname), std::move(sptr));
+}
 
-void Deleter::Init(Dispatcher *held_dp) {
-    held_dp_ = held_dp;
+std::shared_ptr<BaseCommand> Dispatcher::Find(uint32_t id) const {
+    return id < registers_.size() ? registers_[id] : nullptr;
 }
 
-Deleter::~Deleter() noexcept {
-    delete held_dp_;
-    held_dp_ = nullptr;
+std::shared_ptr<BaseCommand> Dispatcher::Find(const std::string &command) const {
+    std::optional<uint32_t> id = SymbolTable::Instance().Find(command);
+    return id ? Find(*id) : nullptr;
 }
 
+std::shared_ptr<Object> Dispatcher::Call(const std::shared_ptr<BaseCommand> &function,
+                                         std::vector<std::shared_ptr<Object>> &args) {
+    if (!function) {
+        throw NameError("Dispatcher: function not found\n");
+    }
+    if (function->GetType() != cmd::Arithmetic && function->GetType() != cmd::Transpose) {
+        // deferred matrix expressions are consumed here
+        for (auto &arg: args) {
+            arg = Materialize(arg);
+        }
+    }
+    return function->Run(args);
+}
+
+void Dispatcher::SetCommand(const std::string& name, std::shared_ptr<BaseCommand> command) {
+    uint32_t id = SymbolTable::Instance().Intern(name);
+    if (id >= registers_.size()) {
+        registers_.resize(id + 1);
+    }
+    registers_[id] = std::move(command);
+}
+
+void Dispatcher::SetPivotMode(cmd::PivotMode pivot_mode) {
+    for (auto &command: registers_) { // commands may be shared, so they are replaced, not changed
+        if (command && command->GetType() == cmd::MatrixLinearTransform) {
+            command = std::static_pointer_cast<LinearTransformationCommand>(command)->WithPivotMode(pivot_mode);
+        }
+    }
+}
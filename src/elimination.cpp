@@ -0,0 +1,297 @@
+#include "elimination.h"
+
+
+static bool IsZero(const sptrObj &value) {
+    return As<Rational>(value)->Numerator() == 0;
+}
+
+static Matrix Block(const std::vector<std::vector<sptrObj>> &data, size_t line, size_t column,
+                    size_t lines, size_t columns) {
+    Matrix block(lines, columns);
+    for (size_t curr_l = 0; curr_l < lines; ++curr_l) {
+        for (size_t curr_c = 0; curr_c < columns; ++curr_c) {
+            block[curr_l][curr_c] = data[line + curr_l][column + curr_c];
+        }
+    }
+    return block;
+}
+
+static void PutBlock(std::vector<std::vector<sptrObj>> &data, size_t line, size_t column, const Matrix &block) {
+    auto [lines, columns] = block.size();
+    for (size_t curr_l = 0; curr_l < lines; ++curr_l) {
+        for (size_t curr_c = 0; curr_c < columns; ++curr_c) {
+            data[line + curr_l][column + curr_c] = block[curr_l][curr_c];
+        }
+    }
+}
+
+static bool PanelLU(std::vector<std::vector<sptrObj>> &data, size_t first, size_t width,
+                    std::vector<size_t> &permutation, size_t &swaps_count, cmd::PivotMode pivot_mode) {
+    // row by row elimination of columns [first, first + width) in lines [first, n)
+    size_t size = data.size();
+    for (size_t curr = first; curr < first + width; ++curr) {
+        size_t pivot_row = size, pivot_size = 0;
+        for (size_t k = curr; k < size; ++k) {
+            if (IsZero(data[k][curr])) {
+                continue;
+            }
+            size_t bit_size = pivot_mode == cmd::first_nonzero ? 0 : As<Rational>(data[k][curr])->BitSize();
+            if (pivot_row == size || bit_size < pivot_size) {
+                pivot_row = k;
+                pivot_size = bit_size;
+                if (pivot_mode == cmd::first_nonzero) {
+                    break;
+                }
+            }
+        }
+        if (pivot_row == size) {
+            return false;
+        }
+        if (pivot_row != curr) { // whole lines are swapped, so permutation is applied to all blocks at once
+            std::swap(data[pivot_row], data[curr]);
+            std::swap(permutation[pivot_row], permutation[curr]);
+            ++swaps_count;
+        }
+        std::shared_ptr<Evaluable> pivot = As<Evaluable>(data[curr][curr]);
+        for (size_t i = curr + 1; i < size; ++i) {
+            if (IsZero(data[i][curr])) {
+                continue;
+            }
+            std::shared_ptr<Evaluable> mul_cf = *As<Evaluable>(data[i][curr]) / pivot;
+            data[i][curr] = mul_cf;
+            for (size_t j = curr + 1; j < first + width; ++j) {
+                if (!IsZero(data[curr][j])) {
+                    data[i][j] = *As<Evaluable>(data[i][j]) - (*As<Evaluable>(data[curr][j]) * mul_cf);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+static bool RecursiveLU(std::vector<std::vector<sptrObj>> &data, size_t first, size_t width,
+                        std::vector<size_t> &permutation, size_t &swaps_count, cmd::PivotMode pivot_mode) {
+    if (width <= kBlockSize) {
+        return PanelLU(data, first, width, permutation, swaps_count, pivot_mode);
+    }
+    size_t size = data.size(), left = width / 2, right = width - left, middle = first + left;
+    if (!RecursiveLU(data, first, left, permutation, swaps_count, pivot_mode)) {
+        return false;
+    }
+    // U12 = L11^-1 * A12
+    for (size_t k = first; k < middle; ++k) {
+        for (size_t i = k + 1; i < middle; ++i) {
+            if (IsZero(data[i][k])) {
+                continue;
+            }
+            for (size_t j = middle; j < first + width; ++j) {
+                data[i][j] = *As<Evaluable>(data[i][j]) - (*As<Evaluable>(data[k][j]) * As<Evaluable>(data[i][k]));
+            }
+        }
+    }
+    // A22 -= L21 * U12, the only cubic part
+    Matrix lower = Block(data, middle, first, size - middle, left);
+    Matrix upper = Block(data, first, middle, left, right);
+    Matrix trailing = Block(data, middle, middle, size - middle, right);
+    PutBlock(data, middle, middle, *As<Matrix>(trailing - Matrix::Multiply(lower, false, upper, false)));
+    return RecursiveLU(data, middle, right, permutation, swaps_count, pivot_mode);
+}
+
+bool BlockLU(std::vector<std::vector<sptrObj>> &data, std::vector<size_t> &permutation, size_t &swaps_count,
+             cmd::PivotMode pivot_mode) {
+    permutation.resize(data.size());
+    for (size_t i = 0; i < data.size(); ++i) {
+        permutation[i] = i;
+    }
+    return RecursiveLU(data, 0, data.size(), permutation, swaps_count, pivot_mode);
+}
+
+namespace {
+    constexpr uint64_t kPrime = (uint64_t(1) << 61) - 1;
+
+    uint64_t MulMod(uint64_t lhs, uint64_t rhs) {
+        unsigned __int128 product = static_cast<unsigned __int128>(lhs) * rhs;
+        uint64_t value = uint64_t(product & kPrime) + uint64_t(product >> 61);
+        value = (value & kPrime) + (value >> 61);
+        return value >= kPrime ? value - kPrime : value;
+    }
+
+    uint64_t InverseMod(uint64_t value) { // value^(p - 2)
+        uint64_t result = 1;
+        for (uint64_t power = kPrime - 2; power; power >>= 1) {
+            if (power & 1) {
+                result = MulMod(result, value);
+            }
+            value = MulMod(value, value);
+        }
+        return result;
+    }
+
+    uint64_t Residue(int64_t value) {
+        int64_t residue = value % int64_t(kPrime);
+        return residue < 0 ? residue + kPrime : residue;
+    }
+}
+
+bool IsNonsingularModPrime(const std::vector<std::vector<sptrObj>> &data) {
+    size_t size = data.size();
+    std::vector<std::vector<uint64_t>> residues(size, std::vector<uint64_t>(size));
+    for (size_t i = 0; i < size; ++i) {
+        for (size_t j = 0; j < size; ++j) {
+            auto value = As<Rational>(data[i][j]);
+            residues[i][j] = Residue(value->Numerator());
+            if (value->Denominator() != 1) {
+                uint64_t denominator = Residue(value->Denominator());
+                if (denominator == 0) {
+                    return false;
+                }
+                residues[i][j] = MulMod(residues[i][j], InverseMod(denominator));
+            }
+        }
+    }
+    for (size_t curr = 0; curr < size; ++curr) {
+        size_t pivot_row = curr;
+        while (pivot_row < size && residues[pivot_row][curr] == 0) {
+            ++pivot_row;
+        }
+        if (pivot_row == size) {
+            return false;
+        }
+        std::swap(residues[pivot_row], residues[curr]);
+        uint64_t inverse = InverseMod(residues[curr][curr]);
+        for (size_t i = curr + 1; i < size; ++i) {
+            if (residues[i][curr] == 0) {
+                continue;
+            }
+            uint64_t mul_cf = kPrime - MulMod(residues[i][curr], inverse);
+            for (size_t j = curr + 1; j < size; ++j) {
+                uint64_t value = residues[i][j] + MulMod(residues[curr][j], mul_cf);
+                residues[i][j] = value >= kPrime ? value - kPrime : value;
+            }
+        }
+    }
+    return true;
+}
+
+static Matrix InvertTriangular(const Matrix &matrix, bool lower) {
+    // lower matrices have implied unit diagonal, upper ones have the real one
+    size_t size = matrix.size().first;
+    Matrix inverse(size, size);
+    sptrObj zero = std::make_shared<Rational>(0), one = std::make_shared<Rational>(1);
+    if (size <= kBlockSize) { // substitution
+        for (size_t curr_l = 0; curr_l < size; ++curr_l) {
+            for (size_t curr_c = 0; curr_c < size; ++curr_c) {
+                inverse[curr_l][curr_c] = zero;
+            }
+        }
+        for (size_t step = 0; step < size; ++step) {
+            size_t i = lower ? step : size - 1 - step;
+            inverse[i][i] = lower ? one : *As<Evaluable>(one) / As<Evaluable>(matrix[i][i]);
+            for (size_t j = 0; j < size; ++j) {
+                if (lower ? j >= i : j <= i) {
+                    continue;
+                }
+                std::shared_ptr<Evaluable> sum = std::make_shared<Rational>(0);
+                for (size_t k = std::min(i, j) + (lower ? 0 : 1); k < std::max(i, j) + (lower ? 0 : 1); ++k) {
+                    if (!IsZero(matrix[i][k]) && !IsZero(inverse[k][j])) {
+                        sum = *sum + (*As<Evaluable>(matrix[i][k]) * As<Evaluable>(inverse[k][j]));
+                    }
+                }
+                inverse[i][j] = lower ? -*As<Rational>(sum) : *(-*As<Rational>(sum)) / As<Evaluable>(matrix[i][i]);
+            }
+        }
+        return inverse;
+    }
+    // [[X11, 0], [X21, X22]] for lower, [[X11, X12], [0, X22]] for upper
+    size_t left = size / 2, right = size - left;
+    Matrix first = InvertTriangular(Block(matrix.GetArray(), 0, 0, left, left), lower);
+    Matrix second = InvertTriangular(Block(matrix.GetArray(), left, left, right, right), lower);
+    std::shared_ptr<Evaluable> minus_one = std::make_shared<Rational>(-1);
+    Matrix corner = lower
+                    ? *Matrix::Multiply(*Matrix::Multiply(second, false, Block(matrix.GetArray(), left, 0, right, left),
+                                                          false), false, first, false)
+                    : *Matrix::Multiply(*Matrix::Multiply(first, false, Block(matrix.GetArray(), 0, left, left, right),
+                                                          false), false, second, false);
+    for (auto &value: corner) {
+        value = *minus_one * As<Evaluable>(value);
+    }
+    for (size_t curr_l = 0; curr_l < size; ++curr_l) {
+        for (size_t curr_c = 0; curr_c < size; ++curr_c) {
+            inverse[curr_l][curr_c] = zero;
+        }
+    }
+    PutBlock(inverse.GetArray(), 0, 0, first);
+    PutBlock(inverse.GetArray(), left, left, second);
+    PutBlock(inverse.GetArray(), lower ? left : 0, lower ? 0 : left, corner);
+    return inverse;
+}
+
+std::vector<std::vector<sptrObj>> InverseFromLU(const std::vector<std::vector<sptrObj>> &data,
+                                                const std::vector<size_t> &permutation) {
+    size_t size = data.size();
+    Matrix lower = Block(data, 0, 0, size, size), upper = Block(data, 0, 0, size, size);
+    sptrObj zero = std::make_shared<Rational>(0);
+    for (size_t curr_l = 0; curr_l < size; ++curr_l) {
+        for (size_t curr_c = 0; curr_c < size; ++curr_c) {
+            (curr_c < curr_l ? upper : lower)[curr_l][curr_c] = zero;
+        }
+    }
+    std::shared_ptr<Matrix> product = Matrix::Multiply(InvertTriangular(upper, false), false,
+                                                       InvertTriangular(lower, true), false);
+    // multiplying by P moves column k to position permutation[k]
+    std::vector<std::vector<sptrObj>> inverse(size, std::vector<sptrObj>(size));
+    for (size_t curr_l = 0; curr_l < size; ++curr_l) {
+        for (size_t k = 0; k < size; ++k) {
+            inverse[curr_l][permutation[k]] = (*product)[curr_l][k];
+        }
+    }
+    return inverse;
+}
+
+void ReduceToHessenberg(std::vector<std::vector<sptrObj>> &data, cmd::PivotMode pivot_mode) {
+    size_t size = data.size();
+    for (size_t curr = 1; curr + 1 < size; ++curr) {
+        // pivot for column curr - 1 is searched under subdiagonal
+        size_t pivot_row = size, pivot_size = 0;
+        for (size_t k = curr; k < size; ++k) {
+            if (IsZero(data[k][curr - 1])) {
+                continue;
+            }
+            size_t bit_size = pivot_mode == cmd::first_nonzero ? 0 : As<Rational>(data[k][curr - 1])->BitSize();
+            if (pivot_row == size || bit_size < pivot_size) {
+                pivot_row = k;
+                pivot_size = bit_size;
+                if (pivot_mode == cmd::first_nonzero) {
+                    break;
+                }
+            }
+        }
+        if (pivot_row == size) {
+            continue;
+        }
+        if (pivot_row != curr) { // P * A * P^-1
+            std::swap(data[pivot_row], data[curr]);
+            for (size_t i = 0; i < size; ++i) {
+                std::swap(data[i][pivot_row], data[i][curr]);
+            }
+        }
+        std::shared_ptr<Evaluable> pivot = As<Evaluable>(data[curr][curr - 1]);
+        for (size_t k = curr + 1; k < size; ++k) {
+            if (IsZero(data[k][curr - 1])) {
+                continue;
+            }
+            // E * A * E^-1: line k -= u * line curr, then column curr += u * column k
+            std::shared_ptr<Evaluable> mul_cf = *As<Evaluable>(data[k][curr - 1]) / pivot;
+            for (size_t j = 0; j < size; ++j) {
+                if (!IsZero(data[curr][j])) {
+                    data[k][j] = *As<Evaluable>(data[k][j]) - (*As<Evaluable>(data[curr][j]) * mul_cf);
+                }
+            }
+            for (size_t i = 0; i < size; ++i) {
+                if (!IsZero(data[i][k])) {
+                    data[i][curr] = *As<Evaluable>(data[i][curr]) + (*As<Evaluable>(data[i][k]) * mul_cf);
+                }
+            }
+        }
+    }
+}
@@ -1,77 +1,154 @@
 #include "interpreter.h"
+#include "mapped_file.h"
+
+#include <unistd.h>
 
 
 void Interpreter::Run(const std::string &expression) {
-    std::stringstream ss{expression};
-    Tokenizer tokenizer{&ss};
+    Tokenizer tokenizer{std::string_view(expression)};
+    Execute(&tokenizer);
+}
+
+void Interpreter::Run() {
+    if (MappedFile::IsMappable(STDIN_FILENO)) { // script redirected from file
+        MappedFile script(STDIN_FILENO);
+        Tokenizer tokenizer{script.View()};
+        Execute(&tokenizer);
+        return;
+    }
+    Tokenizer tokenizer{&std::cin};
+    Execute(&tokenizer);
+}
+
+void Interpreter::RunFile(const std::string &path) {
+    MappedFile script(path);
+    Tokenizer tokenizer{script.View()};
+    Execute(&tokenizer);
+}
+
+void Interpreter::RunStream(std::istream &in) {
+    Tokenizer tokenizer{&in, false};
+    Compiler compiler(operation_holder_);
+    auto report = [&](const std::exception &e) { // statement is skipped, next ones are run
+        out_ << e.what();
+        out_.flush();
+        tokenizer.SkipStatement();
+    };
+    auto next = [&] { // may wait for input, so it is done after statement is executed
+        while (true) {
+            try {
+                tokenizer.Next();
+                return;
+            } catch (const std::exception &e) {
+                report(e);
+            }
+        }
+    };
+    next();
+    while (!tokenizer.IsEnd()) {
+        try {
+            if (sptrObj statement = ReadStatement(&tokenizer)) {
+                Program program = compiler.Compile({statement});
+                VirtualMachine(operation_holder_, scheduler_).Execute(program);
+                out_.flush();
+            }
+        } catch (const std::exception &e) {
+            report(e);
+        }
+        next();
+    }
+}
 
-    std::string result;
-    result.reserve(100);
+PreparedScript::PreparedScript(Program &&program, std::vector<std::string> parameters)
+        : program_(std::move(program)),
+          parameters_(std::move(parameters)) {}
 
+std::vector<std::string> PreparedScript::Parameters() const {
+    return parameters_;
+}
+
+PreparedScript Interpreter::Prepare(const std::string &script) {
+    Tokenizer tokenizer{std::string_view(script)};
     std::list<std::shared_ptr<Object>> parsed_script = ReadScript(&tokenizer);
     if (!tokenizer.IsEnd()) {
         throw SyntaxError("no whole line has been read;");
     }
-    for (auto &line: parsed_script) {
-        line = Simplify(line); // make some evaluations, remove `ExpressionObject`s
+    Compiler compiler(operation_holder_);
+    compiler.SetExports(exports_);
+    Program program = compiler.Compile(parsed_script);
+    for (const auto &command: program.commands) {
+        if (!command) {
+            throw NameError("Dispatcher: function not found\n");
+        }
+        if (command->GetType() == cmd::Workspace) {
+            throw RuntimeError("Interpreter::Prepare: snapshot and restore can't be prepared\n");
+        }
     }
+    std::vector<std::string> parameters;
+    for (uint32_t slot: program.parameters) {
+        parameters.push_back(operation_holder_.Name(program.variables[slot]));
+    }
+    return PreparedScript(std::move(program), std::move(parameters));
 }
 
-void Interpreter::Run() {
-    Tokenizer tokenizer{&std::cin};
+void Interpreter::SetExports(std::optional<std::set<std::string>> exports) {
+    exports_ = std::move(exports);
+}
 
-    std::string result;
-    result.reserve(100);
+void Interpreter::SetScheduler(Scheduler *scheduler) {
+    scheduler_ = scheduler;
+}
 
-    std::list<std::shared_ptr<Object>> parsed_script = ReadScript(&tokenizer);
-    if (!tokenizer.IsEnd()) {
+void Interpreter::SetPivotMode(cmd::PivotMode pivot_mode) {
+    operation_holder_.SetPivotMode(pivot_mode);
+}
+
+void Interpreter::SetFileRoot(const std::string &root) {
+    operation_holder_.SetCommand("load", std::make_shared<LoadCommand>(root));
+    operation_holder_.SetCommand("save", std::make_shared<SaveCommand>(root));
+    operation_holder_.SetCommand("snapshot", std::make_shared<WorkspaceCommand>(operation_holder_, false, root));
+    operation_holder_.SetCommand("restore", std::make_shared<WorkspaceCommand>(operation_holder_, true, root));
+}
+
+void Interpreter::Run(const PreparedScript &script, const std::map<std::string, std::shared_ptr<Object>> &inputs) {
+    VirtualMachine(operation_holder_, scheduler_).Execute(script.program_, inputs);
+}
+
+void Interpreter::Execute(Tokenizer *tokenizer) {
+    std::list<std::shared_ptr<Object>> parsed_script = ReadScript(tokenizer);
+    if (!tokenizer->IsEnd()) {
         throw SyntaxError("no whole line has been read;");
     }
-    for (auto &line: parsed_script) {
-        line = Simplify(line); // make some evaluations, remove `ExpressionObject`s
+    // snapshot and restore see the whole workspace, so statements before them are run and committed first,
+    // with all their variables kept
+    auto begin = parsed_script.begin();
+    for (auto it = begin; it != parsed_script.end(); ++it) {
+        if (IsWorkspaceStatement(*it)) {
+            Execute({begin, it}, std::nullopt);
+            Execute({*it}, std::nullopt);
+            begin = std::next(it);
+        }
     }
+    Execute({begin, parsed_script.end()}, exports_);
 }
 
-std::shared_ptr<Object> Interpreter::Simplify(std::shared_ptr<Object> &object) {
-    if (Is<CommandObject>(object)) {
-        std::shared_ptr<Object> command_name = As<CommandObject>(object)->GetCommand();
-        std::list<std::shared_ptr<Object>> &args = As<CommandObject>(object)->GetArgs();
-        if (Is<Symbol>(command_name)) {
-            if (As<Symbol>(command_name)->GetString() == "init" && Is<Symbol>(args.front())) {
-                args.back() = Simplify(args.back());
-            } else {
-                for (auto &arg: args) {
-                    arg = Simplify(arg);
-                }
-            }
-        } else {
-            throw SyntaxError("Interpreter: invalid command name\n");
-        }
-        return operation_holder_.Invoke(As<Symbol>(command_name)->GetString(), args); // run command(*args)
-    } else if (Is<Matrix>(object)) {
-        for (auto &ptr: *As<Matrix>(object)) {
-            ptr = Simplify(ptr);
-        }
-        return object;
-    } else if (Is<Expression>(object)) {
-        std::list<std::shared_ptr<Object>> &args = As<Expression>(object)->GetArgs();
-        for (auto &arg: args) {
-            arg = Simplify(arg);
-        }
-        As<Expression>(object)->Infix2Postfix();
-        return operation_holder_.Eval(args); // evaluates: Integer{5} Integer{3} Integer{8} Symbol{*} Symbol{-}
-    } else if (Is<Rational>(object)) {
-        return object;
-    } else if (Is<Symbol>(object)) {
-        std::string symbol = As<Symbol>(object)->GetString();
-        if (operation_holder_.IsRegisteredSymbol(symbol)) {
-            return object;
-        }
-        std::shared_ptr<Object> variable = operation_holder_.At(symbol);
-        if (!variable) { // is there such variable
-            throw SyntaxError("Interpreter: unknown symbol was given\n");
-        }
-        return variable;
+void Interpreter::Execute(const std::list<std::shared_ptr<Object>> &statements,
+                          const std::optional<std::set<std::string>> &exports) {
+    if (statements.empty()) {
+        return;
+    }
+    Compiler compiler(operation_holder_);
+    compiler.SetExports(exports);
+    Program program = compiler.Compile(statements);
+    VirtualMachine(operation_holder_, scheduler_).Execute(program);
+}
+
+bool Interpreter::IsWorkspaceStatement(const std::shared_ptr<Object> &statement) const {
+    // nested calls like `let n = snapshot("file");` are rejected by compiler
+    if (!Is<CommandObject>(statement) || !Is<Symbol>(As<CommandObject>(statement)->GetCommand())) {
+        return false;
     }
-    throw SyntaxError("Interpreter: unknown type was given\n");
+    std::shared_ptr<BaseCommand> command =
+            operation_holder_.Find(As<Symbol>(As<CommandObject>(statement)->GetCommand())->GetName());
+    return command && command->GetType() == cmd::Workspace;
 }
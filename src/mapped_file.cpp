@@ -0,0 +1,60 @@
+#include "mapped_file.h"
+#include "error.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+MappedFile::MappedFile(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw RuntimeError("MappedFile: can't open file " + path + ": " + std::strerror(errno) + "\n");
+    }
+    try {
+        Map(fd, path);
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    close(fd); // mapping stays valid without descriptor
+}
+
+MappedFile::MappedFile(int fd) {
+    Map(fd, "descriptor " + std::to_string(fd));
+}
+
+void MappedFile::Map(int fd, const std::string &name) {
+    struct stat info{};
+    if (fstat(fd, &info) < 0 || !S_ISREG(info.st_mode)) {
+        throw RuntimeError("MappedFile: " + name + " is not a regular file\n");
+    }
+    size_ = info.st_size;
+    if (size_ == 0) { // empty mapping is not allowed
+        return;
+    }
+    void *data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        throw RuntimeError("MappedFile: can't map " + name + ": " + std::strerror(errno) + "\n");
+    }
+    madvise(data, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const char *>(data);
+}
+
+MappedFile::~MappedFile() {
+    if (data_) {
+        munmap(const_cast<char *>(data_), size_);
+    }
+}
+
+std::string_view MappedFile::View() const {
+    return {data_, size_};
+}
+
+bool MappedFile::IsMappable(int fd) {
+    struct stat info{};
+    return fstat(fd, &info) == 0 && S_ISREG(info.st_mode);
+}
@@ -0,0 +1,510 @@
+#include "matrix_io.h"
+#include "mapped_file.h"
+#include "rational.h"
+#include "tokenizer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <numeric>
+
+
+namespace {
+    constexpr size_t kMinChunkSize = 1 << 18; // smaller data is read faster than task is spawned
+
+    size_t ChunksCount(size_t size, Scheduler *scheduler) {
+        if (!scheduler || scheduler->Size() <= 1) {
+            return 1;
+        }
+        return std::clamp<size_t>(size / kMinChunkSize, 1, 4 * scheduler->Size());
+    }
+
+    // calls function for every chunk index, as tasks if there are several; error is the one of the first chunk
+    void ForEachChunk(size_t chunks_count, Scheduler *scheduler, const std::function<void(size_t)> &function) {
+        if (chunks_count == 1) {
+            function(0);
+            return;
+        }
+        std::vector<std::exception_ptr> errors(chunks_count);
+        std::atomic<size_t> spawned_count = chunks_count;
+        for (size_t i = 0; i < chunks_count; ++i) {
+            scheduler->Spawn([&, i] {
+                try {
+                    function(i);
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+                spawned_count.fetch_sub(1, std::memory_order_release);
+            }, &spawned_count);
+        }
+        scheduler->Wait([&] { return spawned_count.load(std::memory_order_acquire) == 0; }, &spawned_count);
+        for (const auto &error: errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
+    size_t LineOf(std::string_view text, size_t offset) {
+        return std::count(text.begin(), text.begin() + offset, '\n') + 1;
+    }
+
+    std::string_view Trim(std::string_view cell) {
+        while (!cell.empty() && (cell.front() == ' ' || cell.front() == '\t')) {
+            cell.remove_prefix(1);
+        }
+        while (!cell.empty() && (cell.back() == ' ' || cell.back() == '\t' || cell.back() == '\r')) {
+            cell.remove_suffix(1);
+        }
+        return cell;
+    }
+
+    // returns false if cell is not a number
+    bool ParseCell(std::string_view cell, int64_t *numerator, int64_t *denominator) {
+        bool is_negative = !cell.empty() && cell.front() == '-';
+        if (!cell.empty() && (cell.front() == '-' || cell.front() == '+')) {
+            cell.remove_prefix(1);
+        }
+        size_t read = ParseNumber(cell, numerator, denominator);
+        if (read == 0) {
+            return false;
+        }
+        if (read < cell.size() && cell[read] == '/') { // 1.5/2 == 3/4
+            int64_t divisor_numerator, divisor_denominator;
+            cell.remove_prefix(read + 1);
+            read = ParseNumber(cell, &divisor_numerator, &divisor_denominator);
+            if (read == 0 || divisor_numerator == 0 ||
+                __builtin_mul_overflow(*numerator, divisor_denominator, numerator) ||
+                __builtin_mul_overflow(*denominator, divisor_numerator, denominator)) {
+                return false;
+            }
+        }
+        *numerator = is_negative ? -*numerator : *numerator;
+        return read == cell.size();
+    }
+
+    // parses whole lines of text[begin, end), returns offset of bad line or text.size() if there is none
+    size_t ParseRows(std::string_view text, size_t begin, size_t end, char delimiter,
+                     std::vector<std::vector<sptrObj>> *rows) {
+        while (begin < end) {
+            size_t line_end = std::min(text.find('\n', begin), end);
+            std::string_view line = text.substr(begin, line_end - begin);
+            if (!Trim(line).empty()) {
+                std::vector<sptrObj> &row = rows->emplace_back();
+                while (true) {
+                    size_t cell_end = std::min(line.find(delimiter), line.size());
+                    int64_t numerator, denominator;
+                    try {
+                        if (!ParseCell(Trim(line.substr(0, cell_end)), &numerator, &denominator)) {
+                            return begin;
+                        }
+                    } catch (const SyntaxError &) { // number does not fit
+                        return begin;
+                    }
+                    row.push_back(denominator == 1 ? std::make_shared<Rational>(numerator)
+                                                   : std::make_shared<Rational>(numerator, denominator));
+                    if (cell_end == line.size()) {
+                        break;
+                    }
+                    line.remove_prefix(cell_end + 1);
+                }
+            }
+            begin = line_end + 1;
+        }
+        return text.size();
+    }
+}
+
+std::shared_ptr<Matrix> io::ParseDelimited(std::string_view text, char delimiter, Scheduler *scheduler) {
+    // chunks end at line ends, so every row is parsed by one task
+    size_t chunks_count = ChunksCount(text.size(), scheduler);
+    std::vector<size_t> bounds{0};
+    for (size_t i = 1; i < chunks_count; ++i) {
+        size_t bound = std::max(bounds.back(), text.size() / chunks_count * i);
+        bound = std::min(text.find('\n', bound), text.size());
+        bounds.push_back(std::min(bound + 1, text.size()));
+    }
+    bounds.push_back(text.size());
+
+    std::vector<std::vector<std::vector<sptrObj>>> chunks(chunks_count);
+    std::vector<size_t> errors(chunks_count, text.size());
+    ForEachChunk(chunks_count, scheduler, [&](size_t i) {
+        errors[i] = ParseRows(text, bounds[i], bounds[i + 1], delimiter, &chunks[i]);
+    });
+    // error is the one sequential parsing would find first
+    if (size_t error = *std::min_element(errors.begin(), errors.end()); error < text.size()) {
+        throw RuntimeError("io::ParseDelimited: invalid number in line " + std::to_string(LineOf(text, error)) +
+                           "\n");
+    }
+
+    std::vector<std::vector<sptrObj>> rows;
+    size_t rows_count = 0;
+    for (const auto &chunk: chunks) {
+        rows_count += chunk.size();
+    }
+    rows.reserve(rows_count);
+    for (auto &chunk: chunks) {
+        std::move(chunk.begin(), chunk.end(), std::back_inserter(rows));
+    }
+    if (rows.empty()) { // blank lines are skipped, so text has only them
+        throw RuntimeError("io::ParseDelimited: there are no rows in text\n");
+    }
+    for (size_t i = 1; i < rows.size(); ++i) {
+        if (rows[i].size() != rows.front().size()) {
+            throw RuntimeError("io::ParseDelimited: row " + std::to_string(i + 1) + " has " +
+                               std::to_string(rows[i].size()) + " cells, " + std::to_string(rows.front().size()) +
+                               " were expected\n");
+        }
+    }
+    return std::make_shared<Matrix>(std::move(rows));
+}
+
+namespace {
+    constexpr std::string_view kMagic = "MLBM";
+    constexpr uint8_t kVersion = 1;
+
+    void PutInt(uint64_t value, std::string *out, int size = 8) {
+        for (int i = 0; i < size; ++i) {
+            out->push_back(static_cast<char>(value >> (8 * i)));
+        }
+    }
+
+    uint64_t GetInt(const char *data, int size = 8) {
+        uint64_t value = 0;
+        for (int i = 0; i < size; ++i) {
+            value |= uint64_t(static_cast<uint8_t>(data[i])) << (8 * i);
+        }
+        return value;
+    }
+
+    uint64_t ZigZag(int64_t value) { // small negative numbers get short codes too: 0, -1, 1, -2 -> 0, 1, 2, 3
+        return (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+    }
+
+    int64_t UnZigZag(uint64_t value) {
+        return int64_t(value >> 1) ^ -int64_t(value & 1);
+    }
+
+    size_t VarintSize(int64_t value) {
+        size_t size = 1;
+        for (uint64_t code = ZigZag(value); code >= 0x80; code >>= 7) {
+            ++size;
+        }
+        return size;
+    }
+
+    void PutVarint(int64_t value, std::string *out) {
+        uint64_t code = ZigZag(value);
+        for (; code >= 0x80; code >>= 7) {
+            out->push_back(static_cast<char>(code | 0x80));
+        }
+        out->push_back(static_cast<char>(code));
+    }
+
+    // returns false if varint is cut or longer than 64 bits
+    bool GetVarint(std::string_view data, size_t *pos, int64_t *value) {
+        uint64_t code = 0;
+        for (int shift = 0; shift < 64 && *pos < data.size(); shift += 7) {
+            uint8_t byte = data[(*pos)++];
+            code |= uint64_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                *value = UnZigZag(code);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    RuntimeError InvalidBinary() {
+        return RuntimeError("io::DecodeMatrix: invalid binary matrix\n");
+    }
+
+    sptrObj MakeRational(int64_t numerator, int64_t denominator) {
+        if (denominator <= 0) {
+            throw InvalidBinary();
+        }
+        return denominator == 1 ? std::make_shared<Rational>(numerator)
+                                : std::make_shared<Rational>(numerator, denominator);
+    }
+}
+
+namespace {
+    // numerators scaled to common denominator, false if some of them does not fit in int64
+    bool CollectNumerators(const Matrix &matrix, int64_t common_denominator, std::vector<int64_t> *values) {
+        for (size_t i = 0; i < matrix.size().first; ++i) {
+            for (const auto &cell: matrix[i]) {
+                const Rational &value = *As<Rational>(cell);
+                int64_t &numerator = values->emplace_back();
+                if (__builtin_mul_overflow(value.Numerator(), common_denominator / value.Denominator(), &numerator)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // least common multiple of denominators, 0 if it does not fit in int64
+    int64_t CommonDenominator(const Matrix &matrix) {
+        int64_t common_denominator = 1;
+        for (size_t i = 0; i < matrix.size().first; ++i) {
+            for (const auto &cell: matrix[i]) {
+                int64_t denominator = As<Rational>(cell)->Denominator();
+                if (__builtin_mul_overflow(common_denominator, denominator / std::gcd(common_denominator, denominator),
+                                           &common_denominator)) {
+                    return 0;
+                }
+            }
+        }
+        return common_denominator;
+    }
+}
+
+void io::EncodeMatrix(const Matrix &matrix, std::string *out) {
+    auto [lines, columns] = matrix.size();
+    std::vector<int64_t> values;
+    values.reserve(lines * columns);
+    int64_t common_denominator = CommonDenominator(matrix);
+    bool is_common = common_denominator && CollectNumerators(matrix, common_denominator, &values);
+    if (!is_common) {
+        common_denominator = 1;
+        values.clear();
+        values.reserve(lines * columns * 2);
+        for (size_t i = 0; i < lines; ++i) {
+            for (const auto &cell: matrix[i]) {
+                values.push_back(As<Rational>(cell)->Numerator());
+                values.push_back(As<Rational>(cell)->Denominator());
+            }
+        }
+    }
+    size_t varint_size = 0;
+    for (int64_t value: values) {
+        varint_size += VarintSize(value);
+    }
+    bool is_varint = varint_size * 4 < values.size() * 8 * 3; // int64 are read faster, so varints must save a lot
+
+    out->append(kMagic);
+    out->push_back(static_cast<char>(kVersion));
+    out->push_back(static_cast<char>((is_varint ? kVarint : 0) | (is_common ? kCommonDenominator : 0)));
+    out->append(2, '\0');
+    PutInt(lines, out);
+    PutInt(columns, out);
+    PutInt(common_denominator, out);
+    PutInt(is_varint ? varint_size : values.size() * 8, out);
+    out->reserve(out->size() + (is_varint ? varint_size : values.size() * 8));
+    for (int64_t value: values) {
+        is_varint ? PutVarint(value, out) : PutInt(value, out);
+    }
+}
+
+std::shared_ptr<Matrix> io::DecodeMatrix(std::string_view data, Scheduler *scheduler) {
+    if (data.size() < kHeaderSize || data.substr(0, kMagic.size()) != kMagic || data[4] != kVersion ||
+        (data[5] & ~(kVarint | kCommonDenominator))) {
+        throw InvalidBinary();
+    }
+    bool is_varint = data[5] & kVarint, is_common = data[5] & kCommonDenominator;
+    uint64_t lines = GetInt(data.data() + 8), columns = GetInt(data.data() + 16);
+    int64_t common_denominator = GetInt(data.data() + 24);
+    uint64_t payload_size = GetInt(data.data() + 32), numbers_count;
+    std::string_view payload = data.substr(kHeaderSize);
+    // every number takes at least a byte, so sizes are checked before anything is allocated; a matrix
+    // with one zero dimension has no cells to bound the other one, so it is rejected
+    if (payload.size() != payload_size || common_denominator <= 0 || (lines == 0) != (columns == 0) ||
+        __builtin_mul_overflow(lines, columns, &numbers_count) ||
+        __builtin_mul_overflow(numbers_count, is_common ? 1 : 2, &numbers_count) ||
+        numbers_count > payload_size || (!is_varint && numbers_count * 8 != payload_size)) {
+        throw InvalidBinary();
+    }
+
+    auto matrix = std::make_shared<Matrix>(lines, columns);
+    if (is_varint) {
+        size_t pos = 0;
+        for (uint64_t i = 0; i < lines; ++i) {
+            for (auto &cell: (*matrix)[i]) {
+                int64_t numerator, denominator = common_denominator;
+                if (!GetVarint(payload, &pos, &numerator) || (!is_common && !GetVarint(payload, &pos, &denominator))) {
+                    throw InvalidBinary();
+                }
+                cell = MakeRational(numerator, denominator);
+            }
+        }
+        if (pos != payload.size()) {
+            throw InvalidBinary();
+        }
+        return matrix;
+    }
+    // int64 cells are at known offsets, so lines are decoded in chunks
+    size_t chunks_count = std::min<size_t>(ChunksCount(payload.size(), scheduler), std::max<uint64_t>(lines, 1));
+    size_t cell_size = is_common ? 8 : 16;
+    ForEachChunk(chunks_count, scheduler, [&](size_t chunk) {
+        for (size_t i = lines * chunk / chunks_count; i < lines * (chunk + 1) / chunks_count; ++i) {
+            const char *number = payload.data() + i * columns * cell_size;
+            for (auto &cell: (*matrix)[i]) {
+                cell = MakeRational(GetInt(number), is_common ? common_denominator : int64_t(GetInt(number + 8)));
+                number += cell_size;
+            }
+        }
+    });
+    return matrix;
+}
+
+void io::SaveMatrix(const Matrix &matrix, const std::string &path) {
+    std::string data;
+    EncodeMatrix(matrix, &data);
+    std::ofstream out(path, std::ios::binary);
+    if (!out.write(data.data(), data.size()) || !out.flush()) {
+        throw RuntimeError("io::SaveMatrix: can't write file " + path + "\n");
+    }
+}
+
+namespace {
+    constexpr std::string_view kWorkspaceMagic = "MLBS";
+    constexpr size_t kMinDeferredSize = 1 << 16; // smaller matrices are decoded right away
+
+    enum ValueKind : uint8_t {
+        kRationalValue,
+        kMatrixValue,
+        kPolynomialValue,
+        kStringValue,
+    };
+
+    RuntimeError InvalidWorkspace() {
+        return RuntimeError("io::LoadWorkspace: invalid snapshot file\n");
+    }
+
+    // takes size bytes from data at pos
+    std::string_view Take(std::string_view data, size_t *pos, uint64_t size) {
+        if (size > data.size() - *pos) {
+            throw InvalidWorkspace();
+        }
+        *pos += size;
+        return data.substr(*pos - size, size);
+    }
+}
+
+void io::SaveWorkspace(const Variables &variables, const std::string &path) {
+    std::string data{kWorkspaceMagic};
+    data.push_back(static_cast<char>(kVersion));
+    data.append(3, '\0');
+    PutInt(variables.size(), &data);
+    std::string value;
+    for (const auto &[name, object]: variables) {
+        value.clear();
+        ValueKind kind;
+        sptrObj materialized = Materialize(object);
+        if (Is<Rational>(materialized)) {
+            kind = kRationalValue;
+            PutInt(As<Rational>(materialized)->Numerator(), &value);
+            PutInt(As<Rational>(materialized)->Denominator(), &value);
+        } else if (Is<Matrix>(materialized)) {
+            kind = kMatrixValue;
+            EncodeMatrix(*As<Matrix>(materialized), &value);
+        } else if (Is<Polynomial>(materialized)) {
+            kind = kPolynomialValue;
+            const auto &coefficients = As<Polynomial>(materialized)->Coefficients();
+            EncodeMatrix(Matrix({std::vector<sptrObj>(coefficients.begin(), coefficients.end())}), &value);
+        } else if (Is<StringObject>(materialized)) {
+            kind = kStringValue;
+            value = As<StringObject>(materialized)->GetValue();
+        } else {
+            throw RuntimeError("io::SaveWorkspace: value of " + name + " can't be saved\n");
+        }
+        PutInt(name.size(), &data, 4);
+        data.append(name);
+        data.push_back(static_cast<char>(kind));
+        PutInt(value.size(), &data);
+        data.append(value);
+    }
+    // old file may be mapped by restored workspace, so new one is written aside and renamed
+    std::string temporary_path = path + ".tmp";
+    {
+        std::ofstream out(temporary_path, std::ios::binary);
+        if (!out.write(data.data(), data.size()) || !out.flush()) {
+            throw RuntimeError("io::SaveWorkspace: can't write file " + temporary_path + "\n");
+        }
+    }
+    if (std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+        std::remove(temporary_path.c_str());
+        throw RuntimeError("io::SaveWorkspace: can't replace file " + path + "\n");
+    }
+}
+
+io::Variables io::LoadWorkspace(const std::string &path) {
+    auto file = std::make_shared<MappedFile>(path);
+    std::string_view data = file->View();
+    size_t pos = 0;
+    std::string_view header = Take(data, &pos, 8);
+    if (header.substr(0, kWorkspaceMagic.size()) != kWorkspaceMagic || header[4] != kVersion) {
+        throw InvalidWorkspace();
+    }
+    uint64_t count = GetInt(Take(data, &pos, 8).data());
+    Variables variables;
+    for (uint64_t index = 0; index < count; ++index) {
+        std::string name{Take(data, &pos, GetInt(Take(data, &pos, 4).data(), 4))};
+        uint8_t kind = Take(data, &pos, 1).front();
+        std::string_view value = Take(data, &pos, GetInt(Take(data, &pos, 8).data()));
+        sptrObj object;
+        if (kind == kRationalValue && value.size() == 16) {
+            object = MakeRational(GetInt(value.data()), GetInt(value.data() + 8));
+        } else if (kind == kMatrixValue && value.size() >= kMinDeferredSize) {
+            // header is checked now, cells when matrix is read; mapping lives as long as matrix is not decoded
+            if (value.size() < kHeaderSize || value.substr(0, kMagic.size()) != kMagic) {
+                throw InvalidWorkspace();
+            }
+            object = std::make_shared<LazyMatrix>(GetInt(value.data() + 8), GetInt(value.data() + 16), [file, value] {
+                return DecodeMatrix(value, &Scheduler::Shared());
+            });
+        } else if (kind == kMatrixValue) {
+            object = DecodeMatrix(value);
+        } else if (kind == kPolynomialValue) {
+            std::shared_ptr<Matrix> coefficients = DecodeMatrix(value);
+            if (coefficients->size().first != 1) {
+                throw InvalidWorkspace();
+            }
+            std::vector<std::shared_ptr<Evaluable>> values;
+            for (const auto &cell: (*coefficients)[0]) {
+                values.push_back(As<Evaluable>(cell));
+            }
+            object = std::make_shared<Polynomial>(std::move(values));
+        } else if (kind == kStringValue) {
+            object = std::make_shared<StringObject>(std::string(value));
+        } else {
+            throw InvalidWorkspace();
+        }
+        variables.emplace_back(std::move(name), std::move(object));
+    }
+    return variables;
+}
+
+std::shared_ptr<Matrix> io::LoadMatrix(const std::string &path) {
+    MappedFile file(path);
+    auto has_extension = [&path](std::string_view extension) {
+        return path.size() >= extension.size() &&
+               path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
+    };
+    if (has_extension(".mlb")) {
+        return DecodeMatrix(file.View(), &Scheduler::Shared());
+    }
+    if (file.View().find_first_not_of(" \t\r\n") == std::string_view::npos) { // every line would be skipped
+        throw RuntimeError("io::LoadMatrix: file " + path + " has no rows\n");
+    }
+    return ParseDelimited(file.View(), has_extension(".tsv") ? '\t' : ',', &Scheduler::Shared());
+}
+
+std::string io::ResolvePath(const std::string &root, const std::string &path) {
+    if (root.empty()) {
+        return path;
+    }
+    std::filesystem::path relative(path);
+    bool is_inside = !path.empty() && !relative.has_root_path();
+    for (const auto &part: relative) {
+        is_inside = is_inside && part != "..";
+    }
+    if (!is_inside) {
+        throw RuntimeError("io::ResolvePath: only relative paths inside of working directory are allowed: " + path + "\n");
+    }
+    return (std::filesystem::path(root) / relative).string();
+}
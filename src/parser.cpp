@@ -8,46 +8,47 @@ constexpr bool IsSpecialSymbol(std::string_view sv) {
 std::list<sptrObj> ReadScript(Tokenizer *tokenizer) {
     std::list<sptrObj> result;
     while (!tokenizer->IsEnd()) {
-        sptrObj line_obj = Read(tokenizer);
-        Token curr_token = tokenizer->GetToken();
-        if (const SemicolonToken *semicolon_token_ptr = std::get_if<SemicolonToken>(&curr_token)) {
-            if (!Is<NoneObject>(line_obj)) {
-                result.push_back(line_obj);
-            }
-        } else {
-            throw SyntaxError("ReadScript: invalid function call (semicolon was forgotten)\n");
+        if (sptrObj statement = ReadStatement(tokenizer)) {
+            result.push_back(statement);
         }
         tokenizer->Next();
     }
     return result;
 }
 
+sptrObj ReadStatement(Tokenizer *tokenizer) {
+    sptrObj line_obj = Read(tokenizer);
+    const Token &curr_token = tokenizer->GetToken();
+    if (!std::get_if<SemicolonToken>(&curr_token)) {
+        throw SyntaxError("ReadScript: invalid function call (semicolon was forgotten)\n");
+    }
+    return Is<NoneObject>(line_obj) ? nullptr : line_obj;
+}
+
 sptrObj Read(Tokenizer *tokenizer, size_t depth) {
     if (tokenizer->IsEnd()) {
         return nullptr;
     }
     sptrObj object;
-    Token curr_token = tokenizer->GetToken();
+    const Token &curr_token = tokenizer->GetToken(); // it follows tokenizer
     if (const SymbolToken *symbol_token_ptr = std::get_if<SymbolToken>(&curr_token)) {
         if (symbol_token_ptr->name_ == "let") { // we are initializing variable
             object = std::make_shared<CommandObject>();
             As<CommandObject>(object)->SetCommand(std::make_shared<Symbol>("init"));
             tokenizer->Next(); // after this tokenizer->GetToken() is expected to return
-            curr_token = tokenizer->GetToken();
             symbol_token_ptr = std::get_if<SymbolToken>(&curr_token);
             if (!symbol_token_ptr) {
                 throw SyntaxError("Read: variable name to be initialized is not a acceptable\n");
             }
-            As<CommandObject>(object)->AddArg(std::move(std::make_shared<Symbol>(symbol_token_ptr->name_)));
+            As<CommandObject>(object)->AddArg(std::move(std::make_shared<Symbol>(std::string(symbol_token_ptr->name_))));
             tokenizer->Next();
             if (!ExpectRead(tokenizer, "=")) {
                 throw SyntaxError("Read: invalid variable declaration (assignment sign was expected)\n");
             }
             As<CommandObject>(object)->AddArg(ReadExpression(tokenizer));
         } else { // we are reading Symbol
-            object = std::make_shared<Symbol>(symbol_token_ptr->name_);
+            object = std::make_shared<Symbol>(std::string(symbol_token_ptr->name_));
             tokenizer->Next();
-            curr_token = tokenizer->GetToken();
             if (const SymbolToken *token_ptr = std::get_if<SymbolToken>(&curr_token)) {
                 if (token_ptr->name_ == "(") { // if reading symbol is a function call
                     sptrObj cmd_obj = std::make_shared<CommandObject>();
@@ -76,8 +77,7 @@ bool ExpectRead(Tokenizer *tokenizer, std::string_view sv) {
     if (tokenizer->IsEnd()) {
         return false;
     }
-    sptrObj object;
-    Token curr_token = tokenizer->GetToken();
+    const Token &curr_token = tokenizer->GetToken();
     if (const SymbolToken *symbol_token_ptr = std::get_if<SymbolToken>(&curr_token)) {
         if (symbol_token_ptr->name_ == sv) {
             tokenizer->Next();
@@ -95,18 +95,19 @@ sptrObj ReadCommandArgs(Tokenizer *tokenizer, sptrObj object) {
     // at end:
     // function(args)_
     //               ^
-    Token curr_token = tokenizer->GetToken();
+    const Token &curr_token = tokenizer->GetToken(); // it follows tokenizer
     if (!std::get_if<SymbolToken>(&curr_token) || !ExpectRead(tokenizer, "(")) {
         throw SyntaxError("ReadCommandArgs: invalid function call (opening bracket was expected)\n");
     }
     while (true) { // reading args of function
-        curr_token = tokenizer->GetToken(); // first arg of function
+        // first arg of function
         const SymbolToken *symbol_token_ptr = std::get_if<SymbolToken>(&curr_token);
         const ConstantToken *constant_token_ptr = std::get_if<ConstantToken>(&curr_token);
+        const StringToken *string_token_ptr = std::get_if<StringToken>(&curr_token);
         const BracketToken *bracket_token_ptr = std::get_if<BracketToken>(&curr_token);
         if (bracket_token_ptr && *bracket_token_ptr == BracketToken::CLOSE) {
             throw SyntaxError("ReadCommandArgs: invalid function argument (closing array branch was not expected)\n");
-        } else if (symbol_token_ptr || constant_token_ptr || bracket_token_ptr) {
+        } else if (symbol_token_ptr || constant_token_ptr || string_token_ptr || bracket_token_ptr) {
             bool is_last_arg; // if it will be true then we received last argument of func and should break loop
             As<CommandObject>(object)->AddArg(ReadExpression(tokenizer, &is_last_arg));
             // here tokenizer->GetToken() is expected to return:
@@ -125,9 +126,119 @@ sptrObj ReadCommandArgs(Tokenizer *tokenizer, sptrObj object) {
 }
 
 
+namespace {
+    constexpr int kUnaryPriority = 3; // -a * b == (-a) * b, but -a ^ b == -(a ^ b)
+
+    // returns priority of binary operation held by token, 0 if token is not a binary operation
+    int BinaryPriority(const Token &token, expr::operation *operation) {
+        const SymbolToken *symbol_tptr = std::get_if<SymbolToken>(&token);
+        if (!symbol_tptr || symbol_tptr->name_.size() != 1) {
+            return 0;
+        }
+        switch (symbol_tptr->name_.front()) {
+            case '+':
+                *operation = expr::Add;
+                return 1;
+            case '-':
+                *operation = expr::Sub;
+                return 1;
+            case '*':
+                *operation = expr::Mul;
+                return 2;
+            case '/':
+                *operation = expr::Div;
+                return 2;
+            case '^':
+                *operation = expr::Pow;
+                return 4;
+            default:
+                return 0;
+        }
+    }
+}
+
+sptrObj ReadOperand(Tokenizer *tokenizer) {
+    // reads constant, string, variable, function call, matrix, bracketed expression or operand with unary sign
+    if (tokenizer->IsEnd()) {
+        throw SyntaxError("ReadExpression: object to be initialized was expected, nothing was received\n");
+    }
+    const Token &curr_token = tokenizer->GetToken(); // it follows tokenizer, so token is used before Next
+    if (const ConstantToken *const_tptr = std::get_if<ConstantToken>(&curr_token)) {
+        sptrObj constant = const_tptr->denominator_ == 1 ? std::make_shared<Rational>(const_tptr->numerator_)
+                                                         : std::make_shared<Rational>(const_tptr->numerator_,
+                                                                                      const_tptr->denominator_);
+        tokenizer->Next();
+        return constant;
+    } else if (const StringToken *string_tptr = std::get_if<StringToken>(&curr_token)) {
+        sptrObj string = std::make_shared<StringObject>(std::string(string_tptr->value_));
+        tokenizer->Next();
+        return string;
+    } else if (const BracketToken *bracket_tptr = std::get_if<BracketToken>(&curr_token)) {
+        if (*bracket_tptr == BracketToken::CLOSE) {
+            throw SyntaxError("ReadExpression: operand was expected, closing square bracket was received\n");
+        }
+        return ReadMatrix(tokenizer);
+    } else if (const SymbolToken *symbol_tptr = std::get_if<SymbolToken>(&curr_token)) {
+        if (symbol_tptr->name_ == "-" || symbol_tptr->name_ == "+") {
+            bool is_negative = symbol_tptr->name_ == "-";
+            tokenizer->Next();
+            sptrObj operand = ReadOperation(tokenizer, kUnaryPriority);
+            if (!is_negative) {
+                return operand;
+            }
+            if (Is<Rational>(operand)) { // negative literal
+                return -*As<Rational>(operand);
+            }
+            return std::make_shared<Expression>(expr::Neg, std::vector<sptrObj>{std::move(operand)});
+        }
+        if (symbol_tptr->name_ == "(") {
+            tokenizer->Next();
+            sptrObj operand = ReadOperation(tokenizer, 0);
+            if (!ExpectRead(tokenizer, ")")) {
+                throw SyntaxError("ReadExpression: closing bracket was expected\n");
+            }
+            return operand;
+        }
+        if (IsSpecialSymbol(symbol_tptr->name_)) {
+            throw SyntaxError("ReadExpression: operand was expected, `" + std::string(symbol_tptr->name_) +
+                              "` was received\n");
+        }
+        sptrObj object = std::make_shared<Symbol>(std::string(symbol_tptr->name_));
+        tokenizer->Next();
+        if (!tokenizer->IsEnd()) {
+            symbol_tptr = std::get_if<SymbolToken>(&curr_token);
+            if (symbol_tptr && symbol_tptr->name_ == "(") { // function call
+                sptrObj cmd_obj = std::make_shared<CommandObject>();
+                As<CommandObject>(cmd_obj)->SetCommand(object);
+                ReadCommandArgs(tokenizer, cmd_obj);
+                return cmd_obj;
+            }
+        }
+        return object;
+    }
+    throw SyntaxError("ReadExpression: semicolon was received unexpectedly\n");
+}
+
+sptrObj ReadOperation(Tokenizer *tokenizer, int min_priority) {
+    // precedence climbing: reads operations with priority not less than min_priority
+    sptrObj lhs = ReadOperand(tokenizer);
+    expr::operation operation;
+    while (!tokenizer->IsEnd()) {
+        int priority = BinaryPriority(tokenizer->GetToken(), &operation);
+        if (priority == 0 || priority < min_priority) {
+            break;
+        }
+        tokenizer->Next();
+        // ^ is right-associative: 2 ^ 3 ^ 2 == 2 ^ (3 ^ 2)
+        sptrObj rhs = ReadOperation(tokenizer, operation == expr::Pow ? priority : priority + 1);
+        lhs = std::make_shared<Expression>(operation, std::vector<sptrObj>{std::move(lhs), std::move(rhs)});
+    }
+    return lhs;
+}
+
 sptrObj ReadExpression(Tokenizer *tokenizer, bool *is_last_arg) {
-    // inner_expr - is param to make function know when to end reading;
-    // if it is true, it is expected to end after `)` or `,` or `]`, else it must stop reading at `;`
+    // is_last_arg - is param to make function know when to end reading;
+    // if it is given, it is expected to end after `)` or `,` or `]`, else it must stop reading at `;`
 
     // at calling moment:
     // val + 1 * A, _        val + 1 * A) _        val + 1 * A] _
@@ -135,88 +246,35 @@ sptrObj ReadExpression(Tokenizer *tokenizer, bool *is_last_arg) {
     // after working:
     // val + 1 * A, _        val + 1 * A) _        val + 1 * A] _
     //              ^                     ^                     ^
-    // in all cases returns list{Symbol("val"), Symbol("+"), Number(1), Symbol("*"), Symbol("A")}
-    std::list<sptrObj> objects;
-    Token curr_token;
-    ConstantToken *const_tptr;
-    SymbolToken *symbol_tptr;
-    BracketToken *bracket_tptr;
-    sptrObj curr_object;
-    size_t open_brackets_count = 0; // we are going to count arithmetic brackets () to handle arithmetic expressions
-    bool is_first_token = true; // to handle first in opening circle branch if it is some difficult expression
-    while (true) {
-        if (tokenizer->IsEnd()) {
-            break; // throw error?
-        }
-        curr_token = tokenizer->GetToken();
-        if ((symbol_tptr = std::get_if<SymbolToken>(&curr_token))) {
-            if (is_last_arg && (symbol_tptr->name_ == "," || symbol_tptr->name_ == ")") &&
-                open_brackets_count == 0) {
-                *is_last_arg = (symbol_tptr->name_ == ")");
-                tokenizer->Next();
-                break;
-            }
-            if (symbol_tptr->name_ == ")") {
-                --open_brackets_count;
-            } else if (is_first_token && symbol_tptr->name_ == "(") {
-                ++open_brackets_count;
-            }
-            curr_object = std::make_shared<Symbol>(symbol_tptr->name_);
+    // in all cases returns Expression(+, {Symbol("val"), Expression(*, {Number(1), Symbol("A")})})
+    sptrObj result = ReadOperation(tokenizer, 0);
+    if (tokenizer->IsEnd()) {
+        return result;
+    }
+    const Token &curr_token = tokenizer->GetToken();
+    if (const SymbolToken *symbol_tptr = std::get_if<SymbolToken>(&curr_token)) {
+        if (is_last_arg && (symbol_tptr->name_ == "," || symbol_tptr->name_ == ")")) {
+            *is_last_arg = (symbol_tptr->name_ == ")");
             tokenizer->Next();
-            curr_token = tokenizer->GetToken();
-            if ((symbol_tptr = std::get_if<SymbolToken>(&curr_token))) {
-                if (symbol_tptr->name_ == "(") { // checking situation of when function is called
-                    if (IsSpecialSymbol(As<Symbol>(curr_object)->GetString())) {
-                        // so we are in some non-function-calling expression
-                        ++open_brackets_count;
-                    } else {
-                        // function call is expected
-                        std::shared_ptr<Object> cmd_obj = std::make_shared<CommandObject>();
-                        As<CommandObject>(cmd_obj)->SetCommand(curr_object);
-                        curr_object = cmd_obj;
-                        ReadCommandArgs(tokenizer, cmd_obj);
-                    }
-                }
-            }
-            objects.push_back(curr_object);
-        } else if ((const_tptr = std::get_if<ConstantToken>(&curr_token))) {
-            objects.push_back(std::make_shared<Rational>(const_tptr->value_));
+            return result;
+        }
+        throw SyntaxError("ReadExpression: unexpected symbol `" + std::string(symbol_tptr->name_) + "` in expression\n");
+    } else if (const BracketToken *bracket_tptr = std::get_if<BracketToken>(&curr_token)) {
+        if (*bracket_tptr == BracketToken::CLOSE && is_last_arg) { // if it is expression in matrix/vector
+            *is_last_arg = true;
             tokenizer->Next();
-        } else if ((bracket_tptr = std::get_if<BracketToken>(&curr_token))) {
-            if (*bracket_tptr == BracketToken::OPEN) {
-                /* from   [..., ...]_  to   [..., ...]_
-                 *        ^                           ^
-                 */
-                objects.push_back(ReadMatrix(tokenizer));
-            } else if (is_last_arg) { // if it is expression in matrix/vector
-                *is_last_arg = true;
-                tokenizer->Next();
-                break;
-            } else {
-                throw SyntaxError("ReadExpression: expression is expected to end with a semicolon, "
-                                  "closing square bracket was received\n");
-            }
-        } else if (std::get_if<SemicolonToken>(&curr_token)) {
-            if (!is_last_arg) {
-                break;
-            } else {
-                // if ReadExpression was called from inner expression, but suddenly received unexpected token
-                throw SyntaxError("ReadExpression: semicolon was received unexpectedly\n");
-            }
-        } else {
-            // even if we handle all 4 existing tokens, there could be some problems if new tokens will be created
-            throw SyntaxError("ReadExpression: invalid token in expression\n");
+            return result;
         }
-        is_first_token = false;
-    }
-
-    if (objects.size() == 1) {
-        return objects.front();
-    } else if (objects.size() > 1) {
-        return std::make_shared<Expression>(std::move(objects));
-    } else {
-        throw SyntaxError("ReadExpression: object to be initialized was expected, nothing was received\n");
+        throw SyntaxError("ReadExpression: expression is expected to end with a semicolon, "
+                          "square bracket was received\n");
+    } else if (std::get_if<SemicolonToken>(&curr_token)) {
+        if (is_last_arg) {
+            // if ReadExpression was called from inner expression, but suddenly received unexpected token
+            throw SyntaxError("ReadExpression: semicolon was received unexpectedly\n");
+        }
+        return result;
     }
+    throw SyntaxError("ReadExpression: operation was expected between operands\n");
 }
 
 
@@ -231,13 +289,12 @@ std::shared_ptr<Object> ReadMatrix(Tokenizer *tokenizer) {
     // function returns shared ptr to Matrix Object,
     // tokenizer at the returning moment returns SECOND closing bracket `]`
     std::vector<std::vector<std::shared_ptr<Object>>> objects;
-    Token curr_token;
+    const Token &curr_token = tokenizer->GetToken(); // it follows tokenizer
     tokenizer->Next();
     while (true) {
         if (tokenizer->IsEnd()) {
             break; // throw error?
         }
-        curr_token = tokenizer->GetToken();
         if (const BracketToken *bracket_token_ptr = std::get_if<BracketToken>(&curr_token)) {
             if (*bracket_token_ptr == BracketToken::OPEN) {
                 objects.push_back(ReadLine(tokenizer));
@@ -270,13 +327,12 @@ std::vector<std::shared_ptr<Object>> ReadLine(Tokenizer *tokenizer) {
     // [a, b, c] _
     //           ^
     std::vector<std::shared_ptr<Object>> objects;
-    Token curr_token;
+    const Token &curr_token = tokenizer->GetToken(); // it follows tokenizer
     tokenizer->Next(); // was [, now we expect some integer or expression
     while (true) {
         if (tokenizer->IsEnd()) {
             break; // throw error?
         }
-        curr_token = tokenizer->GetToken();
         if (const BracketToken *bracket_token_ptr = std::get_if<BracketToken>(&curr_token)) {
             if (*bracket_token_ptr == BracketToken::OPEN) {
                 throw SyntaxError("ReadLine: invalid mat init (in inner vectors)\n"); // throw error mat A = [[1, []]]
@@ -0,0 +1,152 @@
+#include "scheduler.h"
+
+
+namespace {
+    thread_local const Scheduler *current_scheduler = nullptr; // scheduler which current thread works for
+    thread_local size_t current_queue = 0;
+}
+
+Scheduler::Scheduler(size_t threads_count) {
+    threads_count = std::max<size_t>(threads_count, 1);
+    for (size_t i = 0; i <= threads_count; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    workers_.reserve(threads_count);
+    for (size_t i = 0; i < threads_count; ++i) {
+        workers_.emplace_back(&Scheduler::Work, this, i);
+    }
+}
+
+Scheduler::~Scheduler() {
+    {
+        std::lock_guard lock(mutex_);
+        is_stopped_ = true;
+    }
+    changed_.notify_all();
+    for (auto &worker: workers_) {
+        worker.join();
+    }
+}
+
+Scheduler &Scheduler::Shared() {
+    static Scheduler scheduler;
+    return scheduler;
+}
+
+size_t Scheduler::Size() const {
+    return workers_.size();
+}
+
+size_t Scheduler::OwnQueue() const {
+    return current_scheduler == this ? current_queue : workers_.size();
+}
+
+void Scheduler::Spawn(std::function<void()> function, const void *group) {
+    Queue &queue = *queues_[OwnQueue()];
+    {
+        std::lock_guard lock(queue.mutex);
+        queue.tasks.push_back({std::move(function), group});
+    }
+    {
+        std::lock_guard lock(mutex_);
+        ++queued_count_;
+    }
+    changed_.notify_all();
+}
+
+void Scheduler::Run(Task &task) {
+    {
+        std::lock_guard lock(mutex_);
+        --queued_count_;
+    }
+    task.function();
+    Notify();
+}
+
+bool Scheduler::RunOne(size_t own) {
+    Task task{};
+    {
+        std::lock_guard lock(queues_[own]->mutex);
+        if (!queues_[own]->tasks.empty()) { // newest task is the most likely to have its data in cache
+            task = std::move(queues_[own]->tasks.back());
+            queues_[own]->tasks.pop_back();
+        }
+    }
+    for (size_t shift = 1; !task.function && shift < queues_.size(); ++shift) {
+        Queue &victim = *queues_[(own + shift) % queues_.size()];
+        std::lock_guard lock(victim.mutex);
+        if (!victim.tasks.empty()) { // oldest task is the biggest part of victim work
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+    }
+    if (!task.function) {
+        return false;
+    }
+    Run(task);
+    return true;
+}
+
+bool Scheduler::RunOwn(size_t own, const void *group) {
+    Task task{};
+    {
+        std::lock_guard lock(queues_[own]->mutex);
+        auto &tasks = queues_[own]->tasks;
+        // tasks of group were spawned last, so they are found at the back at once
+        for (auto it = tasks.rbegin(); it != tasks.rend(); ++it) {
+            if (it->group == group) {
+                task = std::move(*it);
+                tasks.erase(std::next(it).base());
+                break;
+            }
+        }
+    }
+    if (!task.function) {
+        return false;
+    }
+    Run(task);
+    return true;
+}
+
+bool Scheduler::HasOwn(size_t own, const void *group) {
+    std::lock_guard lock(queues_[own]->mutex);
+    for (const Task &task: queues_[own]->tasks) {
+        if (task.group == group) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Scheduler::Wait(const std::function<bool()> &is_done, const void *group) {
+    size_t own = OwnQueue();
+    while (!is_done()) {
+        if (!group || !RunOwn(own, group)) {
+            // tasks of group taken by others are waited for, they notify when they are done
+            std::unique_lock lock(mutex_);
+            changed_.wait(lock, [&] { return is_done() || (group && HasOwn(own, group)); });
+        }
+    }
+}
+
+void Scheduler::Notify() {
+    {
+        std::lock_guard lock(mutex_); // waiter checks its condition under it, so wakeup is not lost
+    }
+    changed_.notify_all();
+}
+
+void Scheduler::Work(size_t index) {
+    current_scheduler = this;
+    current_queue = index;
+    while (true) {
+        if (RunOne(index)) {
+            continue;
+        }
+        std::unique_lock lock(mutex_);
+        changed_.wait(lock, [this] { return is_stopped_ || queued_count_ > 0; });
+        if (is_stopped_ && queued_count_ == 0) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,264 @@
+#include "server.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <filesystem>
+#include <future>
+#include <thread>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+namespace {
+    constexpr uint32_t kMaxFrameSize = 64 << 20;
+    constexpr size_t kMaxSessions = 1024;
+    constexpr auto kSessionIdleTime = std::chrono::hours(1);
+    constexpr size_t kMaxConnections = 256; // every connection has its own waiting thread
+    constexpr time_t kConnectionIdleSeconds = 600;
+    constexpr int kStopCheckMilliseconds = 1000; // signal may be handled by any thread, so accept isn't interrupted
+
+    volatile std::sig_atomic_t is_stopped = 0;
+
+    void Stop(int) {
+        is_stopped = 1;
+    }
+
+    bool IsPort(const std::string &address) {
+        return !address.empty() && address.size() <= 5 &&
+               std::all_of(address.begin(), address.end(), [](char c) { return c >= '0' && c <= '9'; }) &&
+               std::stoul(address) <= 65535;
+    }
+
+    bool ReadFull(int fd, char *data, size_t size) {
+        while (size > 0) {
+            ssize_t read_count = read(fd, data, size);
+            if (read_count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (read_count <= 0) {
+                return false;
+            }
+            data += read_count;
+            size -= read_count;
+        }
+        return true;
+    }
+
+    bool WriteFull(int fd, const char *data, size_t size) {
+        while (size > 0) {
+            ssize_t written_count = send(fd, data, size, MSG_NOSIGNAL);
+            if (written_count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written_count <= 0) {
+                return false;
+            }
+            data += written_count;
+            size -= written_count;
+        }
+        return true;
+    }
+
+    bool ReadFrame(int fd, std::string &payload) {
+        unsigned char header[4];
+        if (!ReadFull(fd, reinterpret_cast<char *>(header), 4)) {
+            return false;
+        }
+        uint32_t size = uint32_t(header[0]) << 24 | uint32_t(header[1]) << 16 | uint32_t(header[2]) << 8 | header[3];
+        if (size > kMaxFrameSize) {
+            return false;
+        }
+        payload.resize(size);
+        return ReadFull(fd, payload.data(), size);
+    }
+
+    bool WriteFrame(int fd, const std::string &payload) {
+        if (payload.size() > kMaxFrameSize) { // header can't lie about size, or the stream would be broken
+            return false;
+        }
+        uint32_t size = payload.size();
+        char header[4] = {char(size >> 24), char(size >> 16), char(size >> 8), char(size)};
+        return WriteFull(fd, header, 4) && WriteFull(fd, payload.data(), payload.size());
+    }
+}
+
+Server::Server(std::string address, size_t workers_count)
+        : address_(std::move(address)),
+          files_root_(IsPort(address_)
+                      ? (std::filesystem::temp_directory_path() / ("matlang-" + address_ + ".files")).string()
+                      : address_ + ".files"),
+          pool_(workers_count) {}
+
+Server::Session::~Session() {
+    std::error_code error; // nothing can be reported from here
+    std::filesystem::remove_all(directory, error);
+}
+
+void Server::EvictSessions(std::chrono::steady_clock::time_point now,
+                           std::vector<std::shared_ptr<Session>> &evicted) {
+    auto oldest = sessions_.end();
+    for (auto it = sessions_.begin(); it != sessions_.end();) {
+        if (now - it->second->last_used > kSessionIdleTime) {
+            evicted.push_back(std::move(it->second));
+            it = sessions_.erase(it);
+            continue;
+        }
+        if (oldest == sessions_.end() || it->second->last_used < oldest->second->last_used) {
+            oldest = it;
+        }
+        ++it;
+    }
+    if (sessions_.size() >= kMaxSessions) {
+        evicted.push_back(std::move(oldest->second));
+        sessions_.erase(oldest);
+    }
+}
+
+std::shared_ptr<Server::Session> Server::GetSession(const std::string &id) {
+    std::vector<std::shared_ptr<Session>> evicted; // destroyed after unlock, since their directories are removed
+    std::lock_guard lock(sessions_mutex_);
+    auto now = std::chrono::steady_clock::now();
+    auto it = sessions_.find(id);
+    if (it == sessions_.end()) {
+        EvictSessions(now, evicted);
+        // session is stored only when it is confined, so a failed directory leaves no session
+        auto created = std::make_shared<Session>();
+        std::filesystem::path directory = std::filesystem::path(files_root_) / std::to_string(sessions_count_++);
+        std::filesystem::create_directories(directory);
+        created->directory = directory.string();
+        created->interpreter.SetFileRoot(created->directory);
+        created->interpreter.SetPivotMode(pivot_mode_);
+        it = sessions_.emplace(id, std::move(created)).first;
+    }
+    it->second->last_used = now;
+    return it->second;
+}
+
+std::string Server::Process(const std::string &request) {
+    size_t separator = request.find('\n');
+    if (separator == std::string::npos) {
+        return "1Server: session id was expected before script\n";
+    }
+    std::shared_ptr<Session> session = GetSession(request.substr(0, separator));
+    std::lock_guard lock(session->mutex);
+    session->out.str("");
+    char status = '0';
+    try {
+        session->interpreter.Run(request.substr(separator + 1));
+    } catch (const std::exception &e) {
+        status = '1';
+        session->out << e.what();
+    }
+    return status + session->out.str();
+}
+
+void Server::HandleConnection(int fd) {
+    // connection thread only waits for socket, scripts are run by pool so that their count is bounded
+    std::string request;
+    while (ReadFrame(fd, request)) {
+        std::promise<std::string> response;
+        pool_.Submit([&] {
+            try {
+                response.set_value(Process(request));
+            } catch (...) {
+                response.set_exception(std::current_exception());
+            }
+        });
+        std::string payload;
+        try {
+            payload = response.get_future().get();
+        } catch (const std::exception &e) {
+            payload = std::string("1") + e.what();
+        }
+        if (payload.size() > kMaxFrameSize) {
+            payload = "1Server: output of " + std::to_string(payload.size() - 1) + " bytes is more than " +
+                      std::to_string(kMaxFrameSize) + " bytes allowed in response\n";
+        }
+        if (!WriteFrame(fd, payload)) {
+            break;
+        }
+    }
+}
+
+void Server::SetPivotMode(cmd::PivotMode pivot_mode) {
+    pivot_mode_ = pivot_mode;
+}
+
+int Server::Listen() {
+    bool is_port = IsPort(address_);
+    int listen_fd = socket(is_port ? AF_INET : AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        throw RuntimeError("Server::Listen: can't create socket: " + std::string(std::strerror(errno)) + "\n");
+    }
+    int bound;
+    if (is_port) { // only local clients, e.g. from windows to wsl
+        int reuse = 1;
+        setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(std::stoul(address_)));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bound = bind(listen_fd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+    } else {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (address_.size() >= sizeof(address.sun_path)) {
+            throw RuntimeError("Server::Listen: socket path is too long\n");
+        }
+        std::strcpy(address.sun_path, address_.c_str());
+        unlink(address_.c_str()); // left by previous run
+        bound = bind(listen_fd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+    }
+    if (bound < 0 || listen(listen_fd, SOMAXCONN) < 0) {
+        throw RuntimeError("Server::Listen: can't listen " + address_ + ": " + std::strerror(errno) + "\n");
+    }
+    return listen_fd;
+}
+
+void Server::Serve() {
+    int listen_fd = Listen();
+    std::filesystem::remove_all(files_root_); // left by previous run
+    std::signal(SIGINT, Stop);
+    std::signal(SIGTERM, Stop);
+    pollfd listening{listen_fd, POLLIN, 0};
+    while (!is_stopped) {
+        if (poll(&listening, 1, kStopCheckMilliseconds) <= 0) {
+            continue;
+        }
+        int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            throw RuntimeError("Server::Serve: accept failed: " + std::string(std::strerror(errno)) + "\n");
+        }
+        std::lock_guard lock(connections_mutex_);
+        if (connections_.size() >= kMaxConnections) {
+            WriteFrame(fd, "1Server: too many connections\n");
+            close(fd);
+            continue;
+        }
+        timeval timeout{kConnectionIdleSeconds, 0}; // idle client must not hold its thread forever
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        connections_.insert(fd);
+        std::thread([this, fd] {
+            HandleConnection(fd);
+            std::lock_guard lock(connections_mutex_);
+            connections_.erase(fd);
+            close(fd); // under lock, so that stopping server never shuts down reused descriptor
+            connections_closed_.notify_all();
+        }).detach();
+    }
+    close(listen_fd);
+    std::unique_lock lock(connections_mutex_);
+    for (int fd: connections_) { // requests being run are answered, next reads fail
+        shutdown(fd, SHUT_RD);
+    }
+    connections_closed_.wait(lock, [this] { return connections_.empty(); });
+}
@@ -0,0 +1,45 @@
+#include "thread_pool.h"
+
+
+ThreadPool::ThreadPool(size_t threads_count) {
+    threads_count = std::max<size_t>(threads_count, 1);
+    workers_.reserve(threads_count);
+    for (size_t i = 0; i < threads_count; ++i) {
+        workers_.emplace_back(&ThreadPool::Work, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(mutex_);
+        is_stopped_ = true;
+    }
+    has_task_.notify_all();
+    for (auto &worker: workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+    {
+        std::lock_guard lock(mutex_);
+        tasks_.push(std::move(task));
+    }
+    has_task_.notify_one();
+}
+
+void ThreadPool::Work() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(mutex_);
+            has_task_.wait(lock, [this] { return is_stopped_ || !tasks_.empty(); });
+            if (tasks_.empty()) { // stopped and nothing is left
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop();
+        }
+        task();
+    }
+}
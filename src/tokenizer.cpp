@@ -1,107 +1,245 @@
 #include "tokenizer.h"
 #include "error.h"
 
-SymbolToken::SymbolToken(int char_code)
-        : name_(1, static_cast<char>(char_code)) {
+#include <cctype>
+#include <charconv>
+
+SymbolToken::SymbolToken(std::string_view name)
+        : name_(name) {
 }
 
-SymbolToken::SymbolToken(const std::string &s)
-        : name_(s) {
+ConstantToken::ConstantToken(int64_t numerator, int64_t denominator)
+        : numerator_(numerator),
+          denominator_(denominator) {
 }
 
-ConstantToken::ConstantToken(int value)
-        : value_(value) {
+namespace {
+    SyntaxError TooBigNumber() {
+        return SyntaxError("ParseNumber: number does not fit in 64-bit integer\n");
+    }
+
+    int64_t ParseDigits(std::string_view digits) {
+        int64_t value = 0;
+        if (!digits.empty() && std::from_chars(digits.data(), digits.data() + digits.size(), value).ec != std::errc()) {
+            throw TooBigNumber();
+        }
+        return value;
+    }
+
+    int64_t PowerOfTen(int64_t exponent) {
+        int64_t result = 1;
+        for (int64_t i = 0; i < exponent; ++i) {
+            if (__builtin_mul_overflow(result, 10, &result)) {
+                throw TooBigNumber();
+            }
+        }
+        return result;
+    }
 }
 
-Tokenizer::Tokenizer(std::istream *in) : in_(in) {
+Tokenizer::Tokenizer(std::istream *in, bool read_first) : in_(in) {
+    if (read_first) {
+        Next();
+    }
+}
+
+Tokenizer::Tokenizer(std::string_view data) : data_(data) {
     Next();
 }
 
 bool Tokenizer::IsEnd() {
     // returns true if cursor has already read all tokens
-    if (!OnEOF()) {
-        already_read_ = false;
-    }
     return already_read_;
 }
 
 // special tokens for lang: (){},.^+-*/<=>  ;[]
 void Tokenizer::Next() {
+    is_valid_ = false;
     ClearSpace();
     if (OnEOF()) {
         already_read_ = true;
+        is_valid_ = true;
         return;
     }
-    int curr_in_value = in_->peek();
+    unsigned char curr_in_value = data_[pos_];
     if (IsProhibitedSymbol(curr_in_value)) {
         throw SyntaxError("Tokenizer::Next: prohibited symbol was used in script\n");
     } else if (IsSpecialSymbol(curr_in_value)) {
-        in_->get();
-        if (curr_in_value == 43 && std::isdigit(in_->peek())) { // +178
-            curr_token_ = ConstantToken(ReadNumber());
-        } else if (curr_in_value == 45 && std::isdigit(in_->peek())) { // -42
-            curr_token_ = ConstantToken(-ReadNumber());
-        } else if (curr_in_value == 59) { // ;
+        ++pos_;
+        // signs are never part of constant: `2-1` is subtraction, unary minus is handled by parser
+        if (curr_in_value == 59) { // ;
             curr_token_ = SemicolonToken();
         } else if (curr_in_value == 91) { // [
             curr_token_ = BracketToken::OPEN;
         } else if (curr_in_value == 93) { // ]
             curr_token_ = BracketToken::CLOSE;
         } else {                          // !&()*,./<=>^{|}~+-
-            curr_token_ = SymbolToken(curr_in_value);
+            curr_token_ = SymbolToken(data_.substr(pos_ - 1, 1));
         }
     } else {
-        if (std::isdigit(curr_in_value)) {
-            curr_token_ = ConstantToken(ReadNumber());
-            if (std::isalpha(in_->peek())) { // 213x
+        if (curr_in_value == 34) { // "
+            curr_token_ = StringToken{ReadString()};
+        } else if (std::isdigit(curr_in_value)) {
+            curr_token_ = ReadNumber();
+            if (!OnEOF() && std::isalpha(static_cast<unsigned char>(data_[pos_]))) { // 213x
                 throw SyntaxError("Tokenizer::Next: invalid variable name\n");
             }
         } else {
             curr_token_ = SymbolToken(ReadSymbol());
         }
     }
+    is_valid_ = true;
+}
+
+void Tokenizer::SkipStatement() {
+    if (is_valid_ && std::holds_alternative<SemicolonToken>(curr_token_)) {
+        return;
+    }
+    // broken statement may not even consist of tokens, so it is skipped as text
+    while (true) {
+        size_t semicolon = data_.find(';', pos_);
+        if (semicolon != std::string_view::npos) {
+            pos_ = semicolon + 1;
+            curr_token_ = SemicolonToken();
+            is_valid_ = true;
+            return;
+        }
+        pos_ = data_.size();
+        if (!in_ || !std::getline(*in_, buffer_)) {
+            already_read_ = true;
+            return;
+        }
+        buffer_.push_back('\n');
+        data_ = buffer_;
+        pos_ = 0;
+    }
 }
 
-Token Tokenizer::GetToken() {
+const Token &Tokenizer::GetToken() const {
     return curr_token_;
 }
 
-int Tokenizer::ReadNumber() {
-    std::string read_value;
-    while (!OnEOF() && std::isdigit(in_->peek())) {
-        read_value += static_cast<char>(in_->get());
+size_t ParseNumber(std::string_view data, int64_t *numerator_ptr, int64_t *denominator_ptr) {
+    // value is kept exact: 1.25e-1 == 125 / 10^(2 + 1)
+    auto is_digit = [data](size_t pos) {
+        return pos < data.size() && std::isdigit(static_cast<unsigned char>(data[pos]));
+    };
+    size_t pos = 0;
+    while (is_digit(pos)) {
+        ++pos;
     }
-    return std::stoi(read_value);
+    std::string_view integer_part = data.substr(0, pos), fraction_part;
+    if (pos < data.size() && data[pos] == '.' && is_digit(pos + 1)) {
+        size_t fraction_begin = ++pos;
+        while (is_digit(pos)) {
+            ++pos;
+        }
+        fraction_part = data.substr(fraction_begin, pos - fraction_begin);
+    }
+    int64_t exponent = 0;
+    if (pos < data.size() && (data[pos] == 'e' || data[pos] == 'E')) {
+        size_t exponent_begin = pos + 1;
+        bool is_negative = exponent_begin < data.size() && data[exponent_begin] == '-';
+        if (exponent_begin < data.size() && (data[exponent_begin] == '-' || data[exponent_begin] == '+')) {
+            ++exponent_begin;
+        }
+        if (is_digit(exponent_begin)) { // otherwise `e` is left to be reported as part of invalid name
+            pos = exponent_begin;
+            while (is_digit(pos)) {
+                ++pos;
+            }
+            exponent = ParseDigits(data.substr(exponent_begin, pos - exponent_begin));
+            exponent = is_negative ? -exponent : exponent;
+        }
+    }
+    *denominator_ptr = 1;
+    if (fraction_part.empty() && exponent == 0) {
+        *numerator_ptr = ParseDigits(integer_part);
+        return pos;
+    }
+    while (!fraction_part.empty() && fraction_part.back() == '0') { // 1.500 == 15 / 10
+        fraction_part.remove_suffix(1);
+    }
+    int64_t numerator = ParseDigits(integer_part), fraction = ParseDigits(fraction_part);
+    if (numerator == 0 && fraction == 0) {
+        *numerator_ptr = 0;
+        return pos;
+    }
+    if (exponent > 64 || exponent < -64) { // 10^19 does not fit already
+        throw TooBigNumber();
+    }
+    if (__builtin_mul_overflow(numerator, PowerOfTen(fraction_part.size()), &numerator) ||
+        __builtin_add_overflow(numerator, fraction, &numerator)) {
+        throw TooBigNumber();
+    }
+    exponent -= static_cast<int64_t>(fraction_part.size());
+    if (exponent >= 0) {
+        if (__builtin_mul_overflow(numerator, PowerOfTen(exponent), &numerator)) {
+            throw TooBigNumber();
+        }
+        *numerator_ptr = numerator;
+        return pos;
+    }
+    *numerator_ptr = numerator;
+    *denominator_ptr = PowerOfTen(-exponent);
+    return pos;
 }
 
-std::string Tokenizer::ReadSymbol() {
-    std::string read_value;
-    if (!std::isalpha(in_->peek()) && in_->peek() != 95) { // valid string beginning is only _A-Za-z
+ConstantToken Tokenizer::ReadNumber() {
+    int64_t numerator, denominator;
+    pos_ += ParseNumber(data_.substr(pos_), &numerator, &denominator);
+    return {numerator, denominator};
+}
+
+std::string_view Tokenizer::ReadSymbol() {
+    size_t begin = pos_;
+    if (!std::isalpha(static_cast<unsigned char>(data_[pos_])) && data_[pos_] != 95) { // valid string beginning is only _A-Za-z
         throw SyntaxError{"invalid `symbol` declaration"};
     }
-    read_value += static_cast<char>(in_->get());
+    ++pos_;
     // valid string names consist of only _A-Za-z0-9
-    while (!OnEOF() && (std::isalnum(in_->peek()) || in_->peek() == 95)) {
-        read_value += static_cast<char>(in_->get());
+    while (!OnEOF() && (std::isalnum(static_cast<unsigned char>(data_[pos_])) || data_[pos_] == 95)) {
+        ++pos_;
+    }
+    return data_.substr(begin, pos_ - begin);
+}
+
+std::string_view Tokenizer::ReadString() {
+    size_t begin = ++pos_;
+    while (!OnEOF() && data_[pos_] != '"' && data_[pos_] != '\n') {
+        ++pos_;
+    }
+    if (OnEOF() || data_[pos_] != '"') {
+        pos_ = begin; // rest of line is not swallowed by broken literal, so statements after it can be read
+        throw SyntaxError("Tokenizer::Next: string literal is not closed\n");
     }
-    return read_value;
+    return data_.substr(begin, pos_++ - begin);
 }
 
 void Tokenizer::ClearSpace() {
     // clear all space symbols from current cursor position till first non-space symbol
-    while (!OnEOF() && std::isspace(in_->peek())) {
-        in_->get();
+    while (true) {
+        while (!OnEOF() && std::isspace(static_cast<unsigned char>(data_[pos_]))) {
+            ++pos_;
+        }
+        // token never spans lines, so previous line is not needed anymore when next one is read
+        if (!OnEOF() || !in_ || !std::getline(*in_, buffer_)) {
+            return;
+        }
+        buffer_.push_back('\n');
+        data_ = buffer_;
+        pos_ = 0;
     }
 }
 
-bool Tokenizer::OnEOF() {
+bool Tokenizer::OnEOF() const {
     // returns true if cursor is on eof
-    return !std::char_traits<char>::not_eof(in_->peek());
+    return pos_ >= data_.size();
 }
 
 constexpr bool Tokenizer::IsProhibitedSymbol(int char_code) {
-    // prohibited symbols:   $#%'"?@\ //
-    constexpr std::string_view prohibited_symbols = "$#%'\"?@\\";
+    // prohibited symbols:   $#%'?@\ //
+    constexpr std::string_view prohibited_symbols = "$#%'?@\\";
     return prohibited_symbols.find(static_cast<char>(char_code)) != std::string_view::npos;
 }
 
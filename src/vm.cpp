@@ -0,0 +1,300 @@
+#include "vm.h"
+
+#include <functional>
+
+
+namespace {
+    // subtree cheaper than this is computed inline, task costs about as much as this many rational operations
+    constexpr double kTaskCost = 1 << 12;
+
+    enum instruction_state : uint8_t {
+        Pending,
+        Running,
+        Done,
+    };
+
+    CostEstimate EstimateOf(const sptrObj &value) {
+        if (IsMatrixLike(value)) {
+            auto [lines, columns] = Is<Matrix>(value) ? As<Matrix>(value)->size() : As<LazyMatrix>(value)->size();
+            return {lines, columns, 0};
+        }
+        return {0, 0, 0};
+    }
+
+    bool IsInside(const Statement &statement, uint32_t instruction) {
+        return statement.code_begin <= instruction && instruction < statement.code_end;
+    }
+}
+
+VirtualMachine::VirtualMachine(Dispatcher &dispatcher, Scheduler *scheduler)
+        : dispatcher_(dispatcher), scheduler_(scheduler) {}
+
+void VirtualMachine::ExecuteInstruction(const Program &program, const Instruction &instruction,
+                                        std::vector<sptrObj> &call_args) {
+    const uint32_t *args = program.args.data() + instruction.args_begin;
+    switch (instruction.op) {
+        case bc::LoadConst:
+            registers_[instruction.dst] = program.constants[instruction.operand];
+            break;
+        case bc::LoadVar:
+            if (!variables_[instruction.operand]) {
+                throw SyntaxError("Interpreter: unknown symbol was given\n");
+            }
+            registers_[instruction.dst] = variables_[instruction.operand];
+            break;
+        case bc::Call:
+            call_args.clear();
+            for (uint32_t k = 0; k < instruction.args_count; ++k) {
+                call_args.push_back(registers_[args[k]]);
+            }
+            registers_[instruction.dst] = dispatcher_.Call(program.commands[instruction.operand], call_args);
+            break;
+        case bc::MakeMatrix: {
+            size_t lines = instruction.operand, columns = instruction.args_count / lines;
+            std::vector<std::vector<sptrObj>> cells(lines);
+            for (size_t curr_l = 0; curr_l < lines; ++curr_l) {
+                cells[curr_l].reserve(columns);
+                for (size_t curr_c = 0; curr_c < columns; ++curr_c) {
+                    cells[curr_l].push_back(registers_[args[curr_l * columns + curr_c]]);
+                }
+            }
+            registers_[instruction.dst] = std::make_shared<Matrix>(std::move(cells));
+            break;
+        }
+        case bc::Store:
+            variables_[instruction.operand] = Materialize(registers_[args[0]]);
+            break;
+    }
+}
+
+bool VirtualMachine::Plan(const Program &program, const Statement &statement) {
+    bool has_fork = false;
+    std::vector<CostEstimate> arg_estimates;
+    for (uint32_t i = statement.code_begin; i < statement.code_end; ++i) {
+        const Instruction &instruction = program.code[i];
+        const uint32_t *args = program.args.data() + instruction.args_begin;
+        arg_estimates.clear();
+        double subtree_cost = 0;
+        size_t heavy_count = 0;
+        for (uint32_t k = 0; k < instruction.args_count; ++k) {
+            if (IsInside(statement, producers_[args[k]])) {
+                arg_estimates.push_back(estimates_[args[k]]);
+                ++uses_[args[k]];
+                subtree_cost += estimates_[args[k]].cost;
+                heavy_count += estimates_[args[k]].cost >= kTaskCost;
+            } else { // computed by other statement
+                arg_estimates.push_back(EstimateOf(registers_[args[k]]));
+            }
+        }
+        has_fork = has_fork || heavy_count > 1;
+        CostEstimate estimate;
+        switch (instruction.op) {
+            case bc::LoadConst:
+                estimate = EstimateOf(program.constants[instruction.operand]);
+                break;
+            case bc::LoadVar:
+                estimate = EstimateOf(variables_[instruction.operand]);
+                break;
+            case bc::Call: {
+                const auto &command = program.commands[instruction.operand];
+                estimate = command ? command->Estimate(arg_estimates) : CostEstimate{0, 0, 1};
+                break;
+            }
+            case bc::MakeMatrix:
+                estimate = {instruction.operand, instruction.args_count / instruction.operand,
+                            double(instruction.args_count)};
+                break;
+            case bc::Store:
+                continue;
+        }
+        estimate.cost += subtree_cost;
+        estimates_[instruction.dst] = estimate;
+        uses_[instruction.dst] = 0;
+    }
+    return has_fork;
+}
+
+void VirtualMachine::Evaluate(const Program &program, const Statement &statement, uint32_t index, bool is_task) {
+    uint8_t state = Pending;
+    if (!states_[index].compare_exchange_strong(state, Running, std::memory_order_acq_rel)) {
+        // argument shared by several parts of expression is computed by the first one to need it; other tasks
+        // are not run meanwhile, one of them could need a node which is suspended under this wait
+        scheduler_->Wait([&] { return states_[index].load(std::memory_order_acquire) == Done; });
+        if (errors_[index]) {
+            std::rethrow_exception(errors_[index]);
+        }
+        return;
+    }
+    const Instruction &instruction = program.code[index];
+    const uint32_t *args = program.args.data() + instruction.args_begin;
+    try {
+        // heavy arguments but the last one are spawned as tasks, the rest are computed here
+        std::vector<uint32_t> heavy, light;
+        for (uint32_t k = 0; k < instruction.args_count; ++k) {
+            uint32_t producer = producers_[args[k]];
+            if (IsInside(statement, producer)) {
+                (estimates_[args[k]].cost >= kTaskCost ? heavy : light).push_back(producer);
+            }
+        }
+        bool is_fork = heavy.size() > 1;
+        std::atomic<size_t> spawned_count = is_fork ? heavy.size() - 1 : 0;
+        for (size_t k = 0; k + 1 < heavy.size(); ++k) {
+            scheduler_->Spawn([&, producer = heavy[k]] {
+                try {
+                    Evaluate(program, statement, producer, true);
+                } catch (...) {
+                    // it is kept in errors_
+                }
+                spawned_count.fetch_sub(1, std::memory_order_release);
+            }, &spawned_count);
+        }
+        try {
+            for (uint32_t producer: light) {
+                Evaluate(program, statement, producer, false);
+            }
+            if (!heavy.empty()) {
+                Evaluate(program, statement, heavy.back(), is_fork);
+            }
+        } catch (...) {
+            // tasks use this frame, so they are waited for anyway
+        }
+        scheduler_->Wait([&] { return spawned_count.load(std::memory_order_acquire) == 0; }, &spawned_count);
+        for (uint32_t k = 0; k < instruction.args_count; ++k) { // error is the one sequential run would raise
+            uint32_t producer = producers_[args[k]];
+            if (IsInside(statement, producer) && errors_[producer]) {
+                std::rethrow_exception(errors_[producer]);
+            }
+        }
+        std::vector<sptrObj> call_args;
+        ExecuteInstruction(program, instruction, call_args);
+        // deferred expression must not be evaluated by two threads at once, and task should do its work itself
+        if (instruction.op != bc::Store && (is_task || uses_[instruction.dst] > 1)) {
+            registers_[instruction.dst] = Materialize(registers_[instruction.dst]);
+        }
+    } catch (...) {
+        errors_[index] = std::current_exception();
+        states_[index].store(Done, std::memory_order_release);
+        scheduler_->Notify();
+        throw;
+    }
+    states_[index].store(Done, std::memory_order_release);
+    scheduler_->Notify();
+}
+
+void VirtualMachine::RunStatement(const Program &program, const Statement &statement, std::vector<sptrObj> &call_args) {
+    if (states_ && Plan(program, statement)) {
+        for (uint32_t i = statement.code_begin; i < statement.code_end; ++i) {
+            Evaluate(program, statement, i, false);
+        }
+    } else {
+        for (uint32_t i = statement.code_begin; i < statement.code_end; ++i) {
+            ExecuteInstruction(program, program.code[i], call_args);
+        }
+    }
+    // deferred expression must not be evaluated by two threads at once
+    for (uint32_t shared: statement.shared) {
+        registers_[shared] = Materialize(registers_[shared]);
+    }
+}
+
+void VirtualMachine::Commit(const Program &program, const Statement &statement) {
+    for (uint32_t i = statement.code_begin; i < statement.code_end; ++i) {
+        const Instruction &instruction = program.code[i];
+        if (instruction.op == bc::Store) { // slot may be already overwritten by later statement, register is not
+            dispatcher_.InitObject(program.variables[instruction.operand],
+                                   Materialize(registers_[program.args[instruction.args_begin]]));
+        }
+    }
+}
+
+void VirtualMachine::RunConcurrently(const Program &program) {
+    size_t count = program.statements.size();
+    std::vector<std::vector<uint32_t>> dependents(count);
+    auto waiting = std::make_unique<std::atomic<uint32_t>[]>(count); // dependencies which are not done yet
+    for (uint32_t index = 0; index < count; ++index) {
+        waiting[index] = program.statements[index].dependencies.size();
+        for (uint32_t dependency: program.statements[index].dependencies) {
+            dependents[dependency].push_back(index);
+        }
+    }
+    std::vector<std::exception_ptr> errors(count);
+    std::vector<char> is_done(count, false); // finished without error
+    std::atomic<size_t> finished_count = 0;
+    std::function<void(uint32_t)> start = [&](uint32_t index) {
+        scheduler_->Spawn([&, index] {
+            const Statement &statement = program.statements[index];
+            bool is_ready = true; // statement is skipped if something it depends on has failed
+            for (uint32_t dependency: statement.dependencies) {
+                is_ready = is_ready && is_done[dependency];
+            }
+            if (is_ready) {
+                try {
+                    std::vector<sptrObj> call_args;
+                    RunStatement(program, statement, call_args);
+                    is_done[index] = true;
+                } catch (...) {
+                    errors[index] = std::current_exception();
+                }
+            }
+            for (uint32_t dependent: dependents[index]) {
+                if (waiting[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    start(dependent);
+                }
+            }
+            finished_count.fetch_add(1, std::memory_order_release);
+        }, &finished_count);
+    };
+    for (uint32_t index = 0; index < count; ++index) {
+        if (program.statements[index].dependencies.empty()) {
+            start(index);
+        }
+    }
+    scheduler_->Wait([&] { return finished_count.load(std::memory_order_acquire) == count; }, &finished_count);
+    // skipped statement depends on failed one, which is earlier, so error is met before it
+    for (uint32_t index = 0; index < count; ++index) {
+        if (errors[index]) {
+            std::rethrow_exception(errors[index]);
+        }
+        Commit(program, program.statements[index]);
+    }
+}
+
+void VirtualMachine::Execute(const Program &program, const std::map<std::string, sptrObj> &bindings) {
+    registers_.assign(program.registers_count, nullptr);
+    variables_.assign(program.variables.size(), nullptr);
+    // variables defined outside of the program are read beforehand, so that statements only read slots;
+    // restored matrices are decoded here, when they are read first
+    for (uint32_t slot: program.parameters) {
+        variables_[slot] = Materialize(dispatcher_.At(program.variables[slot]));
+        if (!bindings.empty()) {
+            auto it = bindings.find(dispatcher_.Name(program.variables[slot]));
+            if (it != bindings.end()) {
+                variables_[slot] = Materialize(it->second);
+            }
+        }
+    }
+    bool is_concurrent = scheduler_ && scheduler_->Size() > 1;
+    states_.reset();
+    if (is_concurrent) {
+        producers_.assign(program.registers_count, 0);
+        for (uint32_t i = 0; i < program.code.size(); ++i) {
+            if (program.code[i].op != bc::Store) {
+                producers_[program.code[i].dst] = i;
+            }
+        }
+        estimates_.assign(program.registers_count, {});
+        uses_.assign(program.registers_count, 0);
+        errors_.assign(program.code.size(), nullptr);
+        states_ = std::make_unique<std::atomic<uint8_t>[]>(program.code.size());
+    }
+    if (is_concurrent && program.statements.size() > 1) {
+        RunConcurrently(program);
+    } else {
+        std::vector<sptrObj> call_args;
+        for (const Statement &statement: program.statements) {
+            RunStatement(program, statement, call_args);
+            Commit(program, statement);
+        }
+    }
+    registers_.clear(); // results of the script should not outlive it
+}
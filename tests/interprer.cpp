@@ -1,10 +1,17 @@
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <sstream>
+#include <thread>
+#include <type_traits>
 
 #include "types/include/matrix.h"
 #include "include/tokenizer.h"
 #include "include/parser.h"
 #include "include/interpreter.h"
+#include "include/cache.h"
+#include "include/matrix_io.h"
+#include "include/elimination.h"
 
 void REQUIRE(bool cond, std::string_view sv = "") {
     if (!cond) {
@@ -97,14 +104,14 @@ int main() {
             0       1       0       0
             0       0       1       0
             0       0       0       1
-            5       0       0       0
-            0       8/5     0       0
-            0       0       -37     0
-            0       0       0       -8
-            5       -6      -7      7
-            0       8/5     46/5    -106/5
-            0       0       -37     111
-            0       0       0       -8
+            1       0       0       0
+            0       2       0       0
+            0       0       11/2    0
+            0       0       0       2368/11
+            1       1       -1      1
+            0       2       -1      27
+            0       0       11/2    95/2
+            0       0       0       2368/11
             45/1184 169/1184        39/592  1/4
             -49/592 -13/592 -3/296  1/2
             -95/2368        301/2368        115/1184        -3/8
@@ -145,5 +152,518 @@ int main() {
                         "print(A);"
         );
     }
+    {
+        Interpreter interpreter;
+        interpreter.Run("let A = [[1, 2/3, 0], [-4, 5, 6]]; "
+                        "let B = [[7, 8], [9, -1/2]]; "
+                        "print(A + A * 2 - A / 2); "
+                        "print(A * transpose(A)); "            // symmetric kernel
+                        "print(transpose(A) * A); "
+                        "print(transpose(A) * B); "
+                        "print(transpose(A) * transpose(B)); "
+                        "print(transpose(A + A) * transpose(B) - transpose(A) * transpose(B) * 2);"
+        );
+    }
+    {
+        Interpreter interpreter;
+        interpreter.Run("let A = [[2/3, 10, 4], [-1/2, 5, 7], [3, 9, 2]]; "
+                        "let p = charpoly(A); "
+                        "print(p); "                                                   // x^3 - 23/3*x^2 - 166/3*x - 320/3
+                        "print(eval(p, 2), det(A - [[2, 0, 0], [0, 2, 0], [0, 0, 2]])); " // -240 240
+                        "print(charpoly([[0, 1, 0, 0], [0, 0, 1, 0], [0, 0, 0, 1], [1, 2, 3, 4]]));"
+        );
+    }
+    {
+        Interpreter interpreter;
+        PreparedScript script = interpreter.Prepare("let S = A * transpose(A) + k; print(S, det(S));");
+        for (const auto &name: script.Parameters()) {
+            std::cout << name << ' ';                                          // A k
+        }
+        std::cout << std::endl;
+        for (int64_t k = 1; k <= 3; ++k) {
+            std::vector<std::vector<sptrObj>> cells{{std::make_shared<Rational>(k), std::make_shared<Rational>(2)},
+                                                    {std::make_shared<Rational>(0), std::make_shared<Rational>(k)}};
+            interpreter.Run(script, {{"A", std::make_shared<Matrix>(std::move(cells))},
+                                     {"k", std::make_shared<Matrix>(std::vector<std::vector<sptrObj>>{
+                                         {std::make_shared<Rational>(k), std::make_shared<Rational>(0)},
+                                         {std::make_shared<Rational>(0), std::make_shared<Rational>(k)}})}});
+        }
+        try {
+            interpreter.Prepare("print(A); foo(A);");                          // nothing is printed
+        } catch (const NameError &e) {
+            std::cout << e.what();
+        }
+    }
+    {
+        Interpreter interpreter;
+        interpreter.Run("print(-(1 + 2), 2-13, 2^3^2, -2^2, (-2)^2, 2 * -3, 2^-2, 1 - -1);" // -3 -11 512 -4 4 -6 1/4 2
+                        "let A = [[1, 1], [1, 0]];"
+                        "print(A^10, -A * 2, [[-1, 2-3], [-(4), 1/-2]]);"
+        );
+    }
+    {
+        Interpreter interpreter;
+        std::string script = "print([[(13 - 2) / 3 * 3, 2 * -(5 + 3)], [det([[1, 2], [3, 4]]), 1/2]]);";
+        std::stringstream ss{script};
+        Tokenizer tokenizer{&ss};
+        Dispatcher dispatcher;
+        Program program = Compiler(dispatcher).Compile(ReadScript(&tokenizer));
+        REQUIRE(program.code.size() == 2 && program.constants.size() == 1, "constant matrix was not folded");
+        interpreter.Run(script);
+        try {
+            interpreter.Run("print(1); print(det([[1, 2]]) + 1);");           // error is left for execution
+        } catch (const RuntimeError &e) {
+            std::cout << e.what();
+        }
+    }
+    {
+        Interpreter interpreter;
+        std::string script = "print(det(A), A * transpose(A)); print(det(A) + 1, A * transpose(A)); "
+                             "let A = A * 2; print(det(A));";
+        std::stringstream ss{script};
+        Tokenizer tokenizer{&ss};
+        Dispatcher dispatcher;
+        Program program = Compiler(dispatcher).Compile(ReadScript(&tokenizer));
+        size_t det_calls = 0;
+        for (const Instruction &instruction: program.code) {
+            det_calls += instruction.op == bc::Call && SymbolTable::Instance().Name(program.command_ids[instruction.operand]) == "det";
+        }
+        REQUIRE(det_calls == 2, "det(A) is computed once before and once after rebinding of A");
+        PreparedScript prepared = interpreter.Prepare(script);
+        interpreter.Run(prepared, {{"A", std::make_shared<Matrix>(std::vector<std::vector<sptrObj>>{
+                {std::make_shared<Rational>(1), std::make_shared<Rational>(2)},
+                {std::make_shared<Rational>(3), std::make_shared<Rational>(4)}})}}); // -2 ... -1 ... -8
+    }
+    {
+        Interpreter interpreter;
+        ResultCache &cache = ResultCache::Instance();
+        cache.Clear();
+        interpreter.Run("let A = [[1, 2, 3], [4, 5, 6], [7, 8, 10]]; print(det(A), inv(A));");
+        interpreter.Run("let B = [[1, 2, 3], [4, 5, 6], [7, 8, 10]]; print(det(B), inv(B));");
+        REQUIRE(cache.Hits() == 2 && cache.Misses() == 2, "same matrices are expected to hit cache");
+        cache.Save("/tmp/matlang_cache.txt");
+        cache.Clear();
+        cache.Load("/tmp/matlang_cache.txt");
+        interpreter.Run("print(det(A));");                                    // -3
+        REQUIRE(cache.Hits() == 1 && cache.Misses() == 0, "loaded results are expected to hit cache");
+        cache.SetLimit(0);
+        REQUIRE(cache.Bytes() == 0, "results are expected to be evicted");
+        cache.SetLimit(64 << 20);
+    }
+    {
+        Interpreter interpreter;
+        interpreter.SetExports(std::set<std::string>{"K"});
+        std::string script = "let H = det(A); let T = rref(A); let K = inv(A); print(T); let T = det([[1, 2]]);";
+        std::stringstream ss{script};
+        Tokenizer tokenizer{&ss};
+        Dispatcher dispatcher;
+        Compiler compiler(dispatcher);
+        compiler.SetExports(std::set<std::string>{"K"});
+        Program program = compiler.Compile(ReadScript(&tokenizer));
+        for (const Instruction &instruction: program.code) {
+            REQUIRE(instruction.op != bc::Call || SymbolTable::Instance().Name(program.command_ids[instruction.operand]) != "det",
+                    "unused bindings are not expected to be evaluated");
+        }
+        interpreter.Run(interpreter.Prepare(script), {{"A", std::make_shared<Matrix>(std::vector<std::vector<sptrObj>>{
+                {std::make_shared<Rational>(2), std::make_shared<Rational>(1)},
+                {std::make_shared<Rational>(1), std::make_shared<Rational>(1)}})}});
+        interpreter.Run("print(K);");
+    }
+    {
+        // dead bindings are not computed even if their arguments are known before execution, nor raise errors
+        Interpreter interpreter;
+        interpreter.SetExports(std::set<std::string>{});
+        ResultCache &cache = ResultCache::Instance();
+        cache.Clear();
+        interpreter.Run("let H = inv([[2, 1], [1, 1]]); let G = inv(H * H * H); let T = det([[1, 2]]); "
+                        "let U = V; let W = foo(1); print(1);");                // 1
+        REQUIRE(cache.Hits() == 0 && cache.Misses() == 0, "dead bindings are not expected to be computed");
+        try {
+            interpreter.Run("let T = det([[1, 2]]); print(T);");
+        } catch (const RuntimeError &e) {
+            std::cout << e.what();                                            // not square
+        }
+    }
+    {
+        // sessions don't share variables and can run concurrently
+        std::stringstream first_out, second_out;
+        Interpreter first(first_out), second(second_out);
+        std::thread first_thread([&] {
+            for (int i = 0; i < 50; ++i) {
+                first.Run("let A = [[1, 2], [3, 4]]; print(det(A));");
+            }
+        });
+        std::thread second_thread([&] {
+            for (int i = 0; i < 50; ++i) {
+                second.Run("let A = [[2, 0], [0, 2]]; print(det(A * A));");
+            }
+        });
+        first_thread.join();
+        second_thread.join();
+        REQUIRE(first_out.str().find("16") == std::string::npos && second_out.str().find("-2") == std::string::npos,
+                "sessions are expected to be isolated");
+        second.Run("let B = 1;");
+        try {
+            first.Run("print(B);");
+        } catch (const SyntaxError &e) {
+            std::cout << e.what();                                            // unknown symbol
+        }
+    }
+    {
+        // independent statements run concurrently, but output and variables are the same as in sequential run
+        std::string script = "let X = [[1, 2, 3], [4, 5, 6], [7, 8, 10]]; let B = inv(X); let C = rref(X * X); "
+                             "print(B); let D = det(B * C) + det(X); print(C, D); let X = X * 2; print(X, B);";
+        std::stringstream sequential_out, concurrent_out;
+        Interpreter sequential(sequential_out), concurrent(concurrent_out);
+        Scheduler scheduler(4);
+        sequential.SetScheduler(nullptr);
+        concurrent.SetScheduler(&scheduler);
+        for (int i = 0; i < 20; ++i) {
+            sequential.Run(script);
+            concurrent.Run(script);
+        }
+        REQUIRE(sequential_out.str() == concurrent_out.str(), "output is expected to be in source order");
+        std::cout << concurrent_out.str().substr(0, concurrent_out.str().size() / 20);
+        try {
+            concurrent_out.str("");
+            concurrent.Run("let E = det(X); let F = inv([[1, 2], [2, 4]]); print(E); let G = 1;");
+        } catch (const RuntimeError &e) {
+            std::cout << concurrent_out.str() << e.what();                     // nothing is printed, det = 0
+        }
+        concurrent_out.str("");
+        concurrent.Run("print(E);");
+        std::cout << concurrent_out.str();                                    // -24
+        try {
+            concurrent.Run("print(G);");
+        } catch (const SyntaxError &e) {
+            std::cout << e.what();                                            // unknown symbol
+        }
+    }
+    {
+        // heavy operands of a single expression are computed as tasks, shared ones only once
+        auto make = [](int seed) { // upper unitriangular, so that numbers stay small
+            std::string matrix = "[";
+            for (int i = 0; i < 16; ++i) {
+                matrix += i ? ", [" : "[";
+                for (int j = 0; j < 16; ++j) {
+                    matrix += (j ? ", " : "") + std::to_string(i == j ? 1 : i < j ? (i * j + seed) % 3 - 1 : 0);
+                }
+                matrix += "]";
+            }
+            return matrix + "]";
+        };
+        std::string inputs = "let A = " + make(1) + "; let B = " + make(2) + "; let C = 2 * " + make(3) + ";";
+        std::string script = "print(det(A * B) + det(B * C), rank(A * B - C) * det(A * B), to_triangle(A * C + B)); "
+                             "print(inv(A * B - A * B) + inv(C));";
+        std::stringstream sequential_out, concurrent_out;
+        Interpreter sequential(sequential_out), concurrent(concurrent_out);
+        Scheduler scheduler(4);
+        sequential.SetScheduler(nullptr);
+        concurrent.SetScheduler(&scheduler);
+        sequential.Run(inputs);
+        concurrent.Run(inputs);
+        std::string sequential_error, concurrent_error;
+        try {
+            sequential.Run(script);
+        } catch (const RuntimeError &e) {
+            sequential_error = e.what();
+        }
+        try {
+            concurrent.Run(script);
+        } catch (const RuntimeError &e) {
+            concurrent_error = e.what();
+        }
+        REQUIRE(sequential_out.str() == concurrent_out.str() && sequential_error == concurrent_error,
+                "parallel evaluation is expected to give the same result");
+        std::cout << concurrent_error;                                        // inverse of singular matrix
+    }
+    {
+        // waiting thread runs only its own tasks: unrelated one could need a node suspended under the wait
+        Scheduler scheduler(1);
+        std::atomic<bool> is_released = false, is_blocked = false;
+        scheduler.Spawn([&] { // worker is busy, so queued tasks can be run only by waiting thread
+            is_blocked = true;
+            while (!is_released) {
+                std::this_thread::yield();
+            }
+        });
+        while (!is_blocked) {
+            std::this_thread::yield();
+        }
+        std::atomic<size_t> unrelated_count = 1, own_count = 1;
+        std::thread::id unrelated_thread, own_thread;
+        scheduler.Spawn([&] {
+            unrelated_thread = std::this_thread::get_id();
+            --unrelated_count;
+        }, &unrelated_count);
+        scheduler.Spawn([&] {
+            own_thread = std::this_thread::get_id();
+            --own_count;
+        }, &own_count);
+        scheduler.Wait([&] { return own_count == 0; }, &own_count);
+        is_released = true;
+        scheduler.Wait([&] { return unrelated_count == 0; });
+        REQUIRE(own_thread == std::this_thread::get_id() && unrelated_thread != own_thread,
+                "waiting thread is expected to run only tasks of its own group");
+    }
+    {
+        // shared heavy operand is read by sibling tasks, which are spawned and waited for by several workers
+        std::string matrix = "[";
+        for (int i = 0; i < 16; ++i) {
+            matrix += i ? ", [" : "[";
+            for (int j = 0; j < 16; ++j) {
+                matrix += (j ? ", " : "") + std::to_string(i == j ? 1 : i < j ? (i + 2 * j) % 3 - 1 : 0);
+            }
+            matrix += "]";
+        }
+        std::string script = "let A = " + matrix + "]; let B = transpose(A); "
+                             "print((A * B) * (B * A) + (A * B) * (A * A) + (A * B) * (B * B) - (A * B));";
+        std::stringstream sequential_out;
+        Interpreter sequential(sequential_out);
+        sequential.SetScheduler(nullptr);
+        sequential.Run(script);
+        Scheduler scheduler(4);
+        for (int run = 0; run < 50; ++run) {
+            std::stringstream concurrent_out;
+            Interpreter concurrent(concurrent_out);
+            concurrent.SetScheduler(&scheduler);
+            concurrent.Run(script);
+            REQUIRE(concurrent_out.str() == sequential_out.str(), "shared operand is expected to be computed once");
+        }
+    }
+    {
+        // streamed script gives the same output, statement by statement
+        std::string script = "let A = [[1, 2], [3, 4]]; print(det(A)); ; let B = A * A - 1 * A; print(B, inv(B)); print(C);";
+        std::stringstream script_out, stream_out, in{script};
+        Interpreter whole(script_out), streamed(stream_out);
+        std::string error;
+        try {
+            whole.Run(script);
+        } catch (const SyntaxError &e) {
+            error = e.what();
+        }
+        streamed.RunStream(in);                                               // error is printed, not thrown
+        std::cout << stream_out.str();                                        // -2, B, inv(B), unknown symbol
+        REQUIRE(script_out.str() + error == stream_out.str(), "streamed output is expected to be the same");
+    }
+    {
+        // broken statements of stream are reported and skipped, the following ones are run
+        std::stringstream out, in{"$ print(1); print(2); print(det([[1, 2]])); let x = ; print(3);\n"
+                                  "print(\"abc); print(4); 213x; print(5); print(y)\nprint(6); print(7); print(8)"};
+        Interpreter interpreter(out);
+        interpreter.RunStream(in);
+        REQUIRE(out.str() == "Tokenizer::Next: prohibited symbol was used in script\n2\n"
+                             "LinearTransformationCommand::Run: (det) det is only for square matrices\n"
+                             "ReadExpression: semicolon was received unexpectedly\n3\n"
+                             "Tokenizer::Next: string literal is not closed\n4\n"
+                             "Tokenizer::Next: invalid variable name\n5\n"
+                             "ReadScript: invalid function call (semicolon was forgotten)\n7\n"
+                             "ReadScript: invalid function call (semicolon was forgotten)\n",
+                "stream is expected to go on after errors");
+    }
+    {
+        // script file is mapped and tokenized in place
+        std::ofstream("/tmp/matlang_script.ml") << "let A = [[1, 2],\n     [3, 4]];\nprint(det(A), A_1);";
+        Interpreter interpreter;
+        try {
+            interpreter.RunFile("/tmp/matlang_script.ml");
+        } catch (const SyntaxError &e) {
+            std::cout << e.what();                                            // unknown symbol
+        }
+        try {
+            interpreter.RunFile("/tmp/matlang_no_such_script.ml");
+        } catch (const RuntimeError &e) {
+            std::cout << "can't open\n";
+        }
+    }
+    {
+        // decimal and scientific literals are exact fractions
+        Interpreter interpreter;
+        interpreter.Run("print(1.25, 2.50 - 1/2, 1.5e-3, 3E+2, 0.000e99, -0.1 * 10);"); // 5/4 2 3/2000 300 0 -1
+        try {
+            interpreter.Run("print(9223372036854775808);");
+        } catch (const SyntaxError &e) {
+            std::cout << e.what();                                            // does not fit
+        }
+    }
+    {
+        // matrix is loaded from delimited text file
+        std::ofstream("/tmp/matlang_matrix.csv") << "1, 2.5, -3/4\r\n\n 4 ,1e2, +0.125\n";
+        std::ofstream("/tmp/matlang_matrix.tsv") << "1\t2\n3\t4\n";
+        std::ofstream("/tmp/matlang_bad_matrix.csv") << "1,2\n3,x\n";
+        Interpreter interpreter;
+        interpreter.Run("let A = load(\"/tmp/matlang_matrix.csv\"); print(A, det(load(\"/tmp/matlang_matrix.tsv\")));");
+        try {
+            interpreter.Run("print(load(\"/tmp/matlang_bad_matrix.csv\"));");
+        } catch (const RuntimeError &e) {
+            std::cout << e.what();                                            // invalid number in line 2
+        }
+        std::ofstream("/tmp/matlang_blank_matrix.csv") << " \n\t\r\n\n";
+        std::ofstream("/tmp/matlang_empty_matrix.csv");
+        for (std::string path: {"/tmp/matlang_blank_matrix.csv", "/tmp/matlang_empty_matrix.csv"}) {
+            try {
+                interpreter.Run("print(load(\"" + path + "\"));");
+                REQUIRE(false, "file without rows is expected to be rejected");
+            } catch (const RuntimeError &e) {
+                REQUIRE(std::string(e.what()) == "io::LoadMatrix: file " + path + " has no rows\n", e.what());
+            }
+        }
+    }
+    {
+        // matrix saved in binary format is loaded back as is
+        Interpreter interpreter;
+        interpreter.Run("let A = [[1, 2/3, -5], [7/4, 0, 1]]; save(A, \"/tmp/matlang_matrix.mlb\"); "
+                        "let B = [[9223372036854775807, 1/3], [1/5, -9223372036854775807]]; "
+                        "save(B, \"/tmp/matlang_wide_matrix.mlb\");"
+                        "print(load(\"/tmp/matlang_matrix.mlb\") - A, load(\"/tmp/matlang_wide_matrix.mlb\") - B);");
+        std::ofstream("/tmp/matlang_bad_matrix.mlb") << "MLBM";
+        try {
+            interpreter.Run("print(load(\"/tmp/matlang_bad_matrix.mlb\"));");
+        } catch (const RuntimeError &e) {
+            std::cout << e.what();                                            // invalid binary matrix
+        }
+    }
+    {
+        // header with one zero dimension is rejected before lines are allocated
+        std::string data;
+        io::EncodeMatrix(Matrix({{std::make_shared<Rational>(1)}}), &data);
+        for (int i = 0; i < 16; ++i) {
+            data[8 + i] = i == 5 ? 1 : 0;                                       // 2^40 lines, 0 columns
+        }
+        try {
+            io::DecodeMatrix(data);
+            REQUIRE(false, "matrix with zero columns is expected to be rejected");
+        } catch (const RuntimeError &e) {
+            std::cout << e.what();                                            // invalid binary matrix
+        }
+    }
+    {
+        // workspace is restored from snapshot in another session
+        Scheduler scheduler(4);
+        Interpreter saving, restoring;
+        saving.SetScheduler(&scheduler);
+        saving.Run("let A = [[1, 2/3], [3, 4]]; let x = 5/7; let p = charpoly(A); let name = \"hello\"; "
+                   "snapshot(\"/tmp/matlang_session.mlbs\"); let x = 1;");
+        restoring.Run("let x = 2; let y = 3; restore(\"/tmp/matlang_session.mlbs\"); print(A, x, y, p, name);");
+        try {
+            restoring.Prepare("snapshot(\"/tmp/matlang_session.mlbs\");");
+        } catch (const RuntimeError &e) {
+            std::cout << e.what();                                            // can't be prepared
+        }
+        for (const char *script: {"let B = 5; let n = snapshot(\"/tmp/matlang_session.mlbs\");",
+                                   "let r = restore(\"/tmp/matlang_session.mlbs\"); print(A);"}) {
+            try {
+                saving.Run(script);
+            } catch (const SyntaxError &e) {
+                std::cout << e.what();                                        // only as separate statements
+            }
+        }
+    }
+    {
+        // big matrix is printed in chunks line by line, text is the same as whole
+        std::string script = "let A = [", expected = "[";
+        for (int i = 0; i < 200; ++i) {
+            script += i ? ", [" : "[";
+            expected += i ? "],\n [" : "[";
+            for (int j = 0; j < 200; ++j) {
+                std::string cell = std::to_string((i - j) * 1000003) + (j % 3 ? "/" + std::to_string(j + 2) : "");
+                script += (j ? ", " : "") + cell;
+                expected += (j ? ",\t" : "") + Rational((i - j) * 1000003, j % 3 ? j + 2 : 1).GetString();
+            }
+            script += "]";
+        }
+        std::stringstream out;
+        Interpreter interpreter(out);
+        interpreter.Run(script + "]; print(A, -1/2);");
+        REQUIRE(out.str() == expected + "]]\n-1/2\n", "printed matrix is expected to be the same as its text");
+    }
+    {
+        // files of confined interpreter are kept in its directory
+        std::filesystem::create_directories("/tmp/matlang_root");
+        Interpreter interpreter;
+        interpreter.SetFileRoot("/tmp/matlang_root");
+        interpreter.Run("let A = [[1, 2]]; save(A, \"a.mlb\"); snapshot(\"s.mlbs\"); restore(\"s.mlbs\"); "
+                        "print(load(\"a.mlb\") - A);");
+        REQUIRE(std::filesystem::exists("/tmp/matlang_root/a.mlb"), "file is expected in root directory");
+        for (const char *script: {"save(A, \"/tmp/matlang_escaped.mlb\");", "print(load(\"../matlang_matrix.mlb\"));",
+                                   "snapshot(\"sub/../../s.mlbs\");"}) {
+            try {
+                interpreter.Run(script);
+            } catch (const RuntimeError &e) {
+                std::cout << e.what();                                        // only relative paths ... are allowed
+            }
+        }
+        REQUIRE(!std::filesystem::exists("/tmp/matlang_escaped.mlb"), "file is not expected out of root directory");
+    }
+    {
+        // singular matrix is found before block LU, so its triangle view is built row by row at once
+        std::vector<std::vector<sptrObj>> data(kBlockSize + 6, std::vector<sptrObj>(kBlockSize + 6));
+        for (size_t i = 0; i < data.size(); ++i) {
+            for (size_t j = 0; j < data.size(); ++j) {
+                data[i][j] = std::make_shared<Rational>(i == j || (i > j && (i + j) % 2)); // numbers stay small
+            }
+        }
+        REQUIRE(IsNonsingularModPrime(data), "lower triangular matrix is expected to be nonsingular");
+        data.back() = data.front();
+        REQUIRE(!IsNonsingularModPrime(data), "matrix with equal lines is expected to be singular");
+        Dispatcher dispatcher;
+        std::vector<sptrObj> args{std::make_shared<Matrix>(data)};
+        auto triangle = As<Matrix>(dispatcher.Call(dispatcher.Find("to_triangle"), args));
+        REQUIRE(As<Rational>((*triangle)[data.size() - 1][data.size() - 1])->Numerator() == 0,
+                "last pivot of singular matrix is expected to be 0");
+    }
+    {
+        // lookups of unknown names do not grow symbol table shared by all sessions
+        Dispatcher dispatcher;
+        size_t symbols_count = SymbolTable::Instance().Size();
+        REQUIRE(!dispatcher.At("never_bound_name") && !dispatcher.Find("never_defined_command") &&
+                SymbolTable::Instance().Size() == symbols_count, "unknown names are not expected to be interned");
+        dispatcher.InitObject("z", std::make_shared<Rational>(1));
+        dispatcher.InitObject("a", std::make_shared<Rational>(2));
+        REQUIRE(dispatcher.Variables().size() == 2 && As<Rational>(dispatcher.At("a"))->Numerator() == 2,
+                "bound variables are expected to be found");
+    }
+    {
+        // names of scripts are interned in their own workspace, so they are freed with it
+        size_t symbols_count = SymbolTable::Instance().Size();
+        std::stringstream out;
+        {
+            Interpreter interpreter(out);
+            interpreter.Run("let session_name = 2; let other = session_name * 3; print(other, det([[other]]));");
+            interpreter.Run("print(session_name);");
+            try {
+                interpreter.Run("print(unknown_name);");
+            } catch (const SyntaxError &) {
+            }
+        }
+        REQUIRE(out.str() == "6\n6\n2\n", "session names are expected to be bound: " + out.str());
+        REQUIRE(SymbolTable::Instance().Size() == symbols_count && !SymbolTable::Instance().Find("session_name"),
+                "names of scripts are not expected to be in shared symbol table");
+    }
+    {
+        // rank keeps complete pivoting whatever pivot mode the dispatcher uses
+        for (cmd::PivotMode pivot_mode: {cmd::first_nonzero, cmd::min_bitsize}) {
+            Dispatcher dispatcher;
+            dispatcher.SetPivotMode(pivot_mode);
+            std::vector<sptrObj> args{std::make_shared<Matrix>(std::vector<std::vector<sptrObj>>{
+                    {std::make_shared<Rational>(0), std::make_shared<Rational>(1), std::make_shared<Rational>(0)},
+                    {std::make_shared<Rational>(0), std::make_shared<Rational>(0), std::make_shared<Rational>(1)}})};
+            sptrObj rank = dispatcher.Call(dispatcher.Find("rank"), args);
+            REQUIRE(As<Rational>(rank)->Numerator() == 2, "rank is expected to count pivots found with column swaps");
+        }
+    }
+    {
+        // pivot mode of interpreter changes form of to_triangle, but not det
+        std::stringstream first_nonzero_out, min_bitsize_out;
+        Interpreter first_nonzero(first_nonzero_out), min_bitsize(min_bitsize_out);
+        first_nonzero.SetPivotMode(cmd::first_nonzero);
+        first_nonzero.Run("let A = [[6, 4], [1, 1]]; print(to_triangle(A), det(A));");
+        min_bitsize.Run("let A = [[6, 4], [1, 1]]; print(to_triangle(A), det(A));");
+        REQUIRE(first_nonzero_out.str() == "[[6,\t4],\n [0,\t1/3]]\n2\n", first_nonzero_out.str());
+        REQUIRE(min_bitsize_out.str() == "[[1,\t1],\n [0,\t-2]]\n2\n", min_bitsize_out.str());
+    }
+    static_assert(!std::is_copy_constructible_v<Interpreter> && !std::is_move_constructible_v<Interpreter> &&
+                  !std::is_copy_assignable_v<Interpreter> && !std::is_move_assignable_v<Interpreter>,
+                  "commands of interpreter refer to its own workspace");
     return 0;
 }
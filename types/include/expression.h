@@ -1,42 +1,48 @@
 #pragma once
 
-#include <stack>
-
 #include "object.h"
 #include "matrix.h"
 #include "integer.h"
 
+#include <string_view>
+#include <vector>
+
 #ifndef MATLANG_EXPRESSION_H
 #define MATLANG_EXPRESSION_H
 
 
+namespace expr {
+    enum operation {
+        Add,
+        Sub,
+        Mul,
+        Div,
+        Pow,
+        Neg,  // unary minus, the only operation with one operand
+    };
+}
+
+// node of arithmetic expression tree built by parser, operands are already ordered by priority
 class Expression : public Object {
 private:
-    std::list<sptrObj> args_;
+    expr::operation operation_;
+    std::vector<sptrObj> operands_;
 
 public:
-    Expression();
-
-    explicit Expression(std::list<sptrObj> &&);
-
-private:
-    static int Priority(const std::shared_ptr<Object> &);
-
-    static bool IsOperation(const std::shared_ptr<Object> &);
-
-    static bool IsSymbolEqual(const std::shared_ptr<Object> &, std::string_view);
+    Expression(expr::operation, std::vector<sptrObj> &&);
 
-public:
     std::string GetString() override;
 
-    size_t GetSize() const;
+    [[nodiscard]] expr::operation GetOperation() const;
 
-    void AddArg(sptrObj &&arg);
+    [[nodiscard]] const std::vector<sptrObj> &GetOperands() const;
 
-    std::list<sptrObj> &GetArgs();
+    static std::string_view OperationName(expr::operation); // name of command which performs operation
+};
 
-    void FormatInfix();
-    void Infix2Postfix();
+template<>
+struct TypeTags<Expression> {
+    static constexpr object_type first = object_type::ExpressionT, last = object_type::ExpressionT;
 };
 
 #endif //MATLANG_EXPRESSION_H
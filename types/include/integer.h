@@ -21,6 +21,8 @@ public:
 
     std::string GetString() override;
 
+    void AppendString(std::string &) override;
+
     std::shared_ptr<Evaluable> operator+(const std::shared_ptr<Evaluable> &) const override;
 
     std::shared_ptr<Evaluable> operator-(const std::shared_ptr<Evaluable> &) const override;
@@ -30,6 +32,11 @@ public:
     std::shared_ptr<Evaluable> operator/(const std::shared_ptr<Evaluable> &) const override;
 };
 
+template<>
+struct TypeTags<Integer> {
+    static constexpr object_type first = object_type::IntegerT, last = object_type::IntegerT;
+};
+
 template<typename T>
 std::ostream &operator<<(std::ostream &out, const Integer &value);
 
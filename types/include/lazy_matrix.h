@@ -0,0 +1,94 @@
+#pragma once
+
+#include "object.h"
+#include "rational.h"
+#include "matrix.h"
+#include "error.h"
+
+#include <functional>
+
+#ifndef MATLANG_LAZY_MATRIX_H
+#define MATLANG_LAZY_MATRIX_H
+
+
+class LazyMatrix;
+
+typedef std::shared_ptr<LazyMatrix> sptrLazy;
+
+// node of deferred elementwise matrix expression (sums, differences, products/divisions by scalar, transposition);
+// whole chain is evaluated at once, in one pass over the cells, only when result is really needed;
+// it is not thread-safe: Materialize caches result and frees operands without locking, so node (and any node
+// under it) must not be read by other threads until it is materialized, VM materializes shared registers first
+class LazyMatrix : public Evaluable {
+public:
+    enum class Kind {
+        Leaf,      // already computed matrix
+        Add,       // lhs + rhs
+        Sub,       // lhs - rhs
+        Scale,     // scalar * lhs
+        Divide,    // lhs / scalar
+        Transpose, // lhs^T, only remaps indices
+        Deferred,  // matrix computed by source when it is needed first, e.g. read from mapped file
+    };
+
+private:
+    Kind kind_;
+    std::shared_ptr<Matrix> leaf_;
+    mutable sptrLazy lhs_, rhs_;
+    mutable std::shared_ptr<Evaluable> scalar_;
+    mutable std::function<std::shared_ptr<Matrix>()> source_;
+    size_t lines_{}, columns_{};
+
+    mutable std::shared_ptr<Matrix> materialized_;
+
+    std::shared_ptr<Evaluable> EvalAt(size_t, size_t) const;
+
+    sptrLazy Self() const;
+
+public:
+    explicit LazyMatrix(std::shared_ptr<Matrix>);
+
+    LazyMatrix(Kind, sptrLazy, sptrLazy);
+
+    LazyMatrix(Kind, sptrLazy, std::shared_ptr<Evaluable>);
+
+    explicit LazyMatrix(sptrLazy); // transposition of given node
+
+    // deferred matrix of given size, source is called once
+    LazyMatrix(size_t, size_t, std::function<std::shared_ptr<Matrix>()>);
+
+    static sptrLazy Of(const sptrObj &); // wraps Matrix into leaf node, returns LazyMatrix as is
+
+    [[nodiscard]] std::pair<size_t, size_t> size() const;
+
+    std::shared_ptr<Evaluable> operator+(const std::shared_ptr<Evaluable> &) const override;
+
+    std::shared_ptr<Evaluable> operator-(const std::shared_ptr<Evaluable> &) const override;
+
+    std::shared_ptr<Evaluable> operator*(const std::shared_ptr<Evaluable> &) const override;
+
+    std::shared_ptr<Evaluable> operator/(const std::shared_ptr<Evaluable> &) const override;
+
+    std::shared_ptr<Matrix> Materialize() const;
+
+    // returns computed operand for multiplication and whether it should be read transposed,
+    // so transposition node is never materialized before product
+    std::pair<std::shared_ptr<Matrix>, bool> MultiplicationOperand() const;
+
+    std::string GetString() override;
+
+    void AppendString(std::string &) override;
+};
+
+template<>
+struct TypeTags<LazyMatrix> {
+    static constexpr object_type first = object_type::LazyMatrixT, last = object_type::LazyMatrixT;
+};
+
+// true for Matrix and LazyMatrix
+bool IsMatrixLike(const sptrObj &);
+
+// returns evaluated Matrix for LazyMatrix, any other object is returned unchanged
+sptrObj Materialize(const sptrObj &);
+
+#endif //MATLANG_LAZY_MATRIX_H
@@ -67,6 +67,8 @@ private:
 
     void ThrowIfNotValidMatrix();
 
+    static std::shared_ptr<Matrix> MultiplySymmetric(const Matrix &, bool);
+
 public:
     explicit Matrix(const std::vector<std::vector<sptrObj>> & = {});
 
@@ -108,6 +110,12 @@ public:
 
     std::shared_ptr<Evaluable> Transposed() const;
 
+    // op(lhs) * op(rhs), where op is transposition if flag is set (as in BLAS gemm);
+    // transposed operands are read in place, never copied
+    static std::shared_ptr<Matrix> Multiply(const Matrix &, bool, const Matrix &, bool);
+
+    static std::shared_ptr<Matrix> Power(const Matrix &, uint64_t); // by repeated squaring
+
     void Transpose();
 
     std::vector<std::vector<sptrObj>> DeepCopy() const {
@@ -127,28 +135,34 @@ public:
         return matrix_[i];
     }
 
+    const std::vector<sptrObj> &operator[](size_t i) const {
+        return matrix_[i];
+    }
+
     std::vector<std::vector<sptrObj>> &GetArray();
 
+    const std::vector<std::vector<sptrObj>> &GetArray() const;
+
     std::ostream &PrintOut(std::ostream &out) const;
 
     std::string GetString() override {
-        std::string result = "[";
-        result.reserve((lines_ + 1) * (columns_ + 1));
-        for (size_t curr_l = 0; curr_l < lines_; ++curr_l) {
-            if (curr_l != 0) {
-                result += "],\n ";
-            }
-            result += "[";
-            for (size_t curr_c = 0; curr_c < columns_; ++curr_c) {
-                if (curr_c != 0) {
-                    result += ",\t";
-                }
-                result += matrix_[curr_l][curr_c]->GetString();
-            }
-        }
-        result += "]]";
+        std::string result;
+        AppendString(result);
         return result;
     }
+
+    void AppendString(std::string &out) override {
+        AppendLines(out, 0, lines_);
+    }
+
+    // appends text of lines [begin, end) with brackets and separators, so that big matrix can be printed
+    // line by line: AppendLines(0, 1), AppendLines(1, 2) and so on give the same text as AppendString
+    void AppendLines(std::string &, size_t, size_t);
+};
+
+template<>
+struct TypeTags<Matrix> {
+    static constexpr object_type first = object_type::MatrixT, last = object_type::MatrixT;
 };
 
 std::ostream &operator<<(std::ostream &out, const Matrix &m);
@@ -13,18 +13,27 @@
 #define MATLANG_OBJECT_H
 
 
+// tags of every class and its subclasses go in a row, so type test is comparison with range of tags
 enum object_type {
     ObjectT,
     NoneT,
     SymbolT,
+    StringT,
     CommandT,
     ExpressionT,
+    PolynomialT,
     EvaluableT,
     IntegerT,
-    MatrixT,
     RationalT,
+    MatrixT,
+    LazyMatrixT,
+    ObjectTypesCount,
 };
 
+// range [first, last] of tags of T and its subclasses, specialized next to every class
+template<class T>
+struct TypeTags;
+
 class Object : public std::enable_shared_from_this<Object> {
 private:
     object_type type_;
@@ -35,7 +44,21 @@ public:
 
     virtual ~Object() = default;
 
+    [[nodiscard]] object_type GetType() const {
+        return type_;
+    }
+
     virtual std::string GetString() = 0;
+
+    // appends the same text as GetString gives, often printed types do it without temporary strings
+    virtual void AppendString(std::string &out) {
+        out += GetString();
+    }
+};
+
+template<>
+struct TypeTags<Object> {
+    static constexpr object_type first = object_type::ObjectT, last = object_type::LazyMatrixT;
 };
 
 typedef std::shared_ptr<Object> sptrObj;
@@ -47,7 +70,7 @@ std::shared_ptr<T> As(const sptrObj &obj) {
 
 template<class T>
 bool Is(const sptrObj &obj) {
-    return static_cast<bool>(dynamic_cast<T *>(obj.get()));
+    return obj && TypeTags<T>::first <= obj->GetType() && obj->GetType() <= TypeTags<T>::last;
 }
 
 class NoneObject : public Object {
@@ -60,6 +83,11 @@ public:
     };
 };
 
+template<>
+struct TypeTags<NoneObject> {
+    static constexpr object_type first = object_type::NoneT, last = object_type::NoneT;
+};
+
 class Evaluable : public Object {
 public:
     explicit Evaluable(object_type type = object_type::EvaluableT) : Object(type) {}
@@ -73,6 +101,11 @@ public:
     virtual std::shared_ptr<Evaluable> operator/(const std::shared_ptr<Evaluable> &) const = 0;
 };
 
+template<>
+struct TypeTags<Evaluable> {
+    static constexpr object_type first = object_type::EvaluableT, last = object_type::LazyMatrixT;
+};
+
 class CommandObject : public Object {
 private:
     sptrObj cmd_ptr_;  // ptr to next object
@@ -111,13 +144,22 @@ public:
     }
 };
 
+template<>
+struct TypeTags<CommandObject> {
+    static constexpr object_type first = object_type::CommandT, last = object_type::CommandT;
+};
+
 
 class Symbol : public Object {
 private:
-    std::string name_;
+    std::string name_; // interned by compiler in symbol table of workspace, not at parsing
 
 public:
-    Symbol(const std::string &name) : Object(object_type::SymbolT), name_(name) {
+    explicit Symbol(std::string name) : Object(object_type::SymbolT), name_(std::move(name)) {
+    }
+
+    [[nodiscard]] const std::string &GetName() const {
+        return name_;
     }
 
     std::string GetString() override {
@@ -125,4 +167,32 @@ public:
     };
 };
 
+template<>
+struct TypeTags<Symbol> {
+    static constexpr object_type first = object_type::SymbolT, last = object_type::SymbolT;
+};
+
+
+class StringObject : public Object {
+private:
+    std::string value_;
+
+public:
+    explicit StringObject(std::string value) : Object(object_type::StringT), value_(std::move(value)) {
+    }
+
+    [[nodiscard]] const std::string &GetValue() const {
+        return value_;
+    }
+
+    std::string GetString() override {
+        return "\"" + value_ + "\"";
+    };
+};
+
+template<>
+struct TypeTags<StringObject> {
+    static constexpr object_type first = object_type::StringT, last = object_type::StringT;
+};
+
 #endif //MATLANG_OBJECT_H
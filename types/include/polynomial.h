@@ -0,0 +1,46 @@
+#pragma once
+
+#include "object.h"
+#include "rational.h"
+#include "error.h"
+
+#include <vector>
+
+#ifndef MATLANG_POLYNOMIAL_H
+#define MATLANG_POLYNOMIAL_H
+
+
+// polynomial of one variable with rational coefficients, coefficients_[k] is coefficient of x^k
+class Polynomial : public Object {
+private:
+    std::vector<std::shared_ptr<Evaluable>> coefficients_;
+
+    void Normalize(); // removes leading zero coefficients
+
+public:
+    Polynomial();
+
+    explicit Polynomial(std::vector<std::shared_ptr<Evaluable>> &&);
+
+    [[nodiscard]] size_t Degree() const;
+
+    [[nodiscard]] const std::vector<std::shared_ptr<Evaluable>> &Coefficients() const;
+
+    // value at the point by Horner's scheme
+    std::shared_ptr<Evaluable> Evaluate(const std::shared_ptr<Evaluable> &) const;
+
+    // p(x) * (x - root)
+    std::shared_ptr<Polynomial> MultiplyByLinear(const std::shared_ptr<Evaluable> &) const;
+
+    // p(x) - q(x) * scalar
+    std::shared_ptr<Polynomial> SubtractScaled(const Polynomial &, const std::shared_ptr<Evaluable> &) const;
+
+    std::string GetString() override;
+};
+
+template<>
+struct TypeTags<Polynomial> {
+    static constexpr object_type first = object_type::PolynomialT, last = object_type::PolynomialT;
+};
+
+#endif //MATLANG_POLYNOMIAL_H
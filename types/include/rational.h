@@ -34,10 +34,14 @@ public:
 
     std::string GetString() override;
 
+    void AppendString(std::string &) override;
+
     [[nodiscard]] int64_t Numerator() const;
 
     [[nodiscard]] int64_t Denominator() const;
 
+    [[nodiscard]] size_t BitSize() const; // bits of numerator and denominator together
+
     std::shared_ptr<Evaluable> operator+() const;
 
     std::shared_ptr<Evaluable> operator-() const;
@@ -45,4 +49,9 @@ public:
     void Update();
 };
 
+template<>
+struct TypeTags<Rational> {
+    static constexpr object_type first = object_type::RationalT, last = object_type::RationalT;
+};
+
 #endif //MATLANG_RATIONAL_H
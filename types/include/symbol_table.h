@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#ifndef MATLANG_SYMBOL_TABLE_H
+#define MATLANG_SYMBOL_TABLE_H
+
+
+// interned names: every distinct name gets small integer id once (at compiling), later it is compared and
+// looked up by id only; names are never removed, so shared instance holds only names of commands and every
+// workspace has its own table for the rest, which is freed with it
+class SymbolTable {
+private:
+    std::deque<std::string> names_; // deque keeps references to names valid while it grows
+    std::unordered_map<std::string_view, uint32_t> ids_;
+    mutable std::shared_mutex mutex_;
+
+public:
+    SymbolTable() = default;
+
+    SymbolTable(const SymbolTable &) = delete;
+
+    SymbolTable &operator=(const SymbolTable &) = delete;
+
+    static SymbolTable &Instance(); // names of commands
+
+    uint32_t Intern(std::string_view);
+
+    [[nodiscard]] std::optional<uint32_t> Find(std::string_view) const; // lookup only, unknown names are not added
+
+    [[nodiscard]] const std::string &Name(uint32_t) const;
+
+    [[nodiscard]] size_t Size() const;
+};
+
+#endif //MATLANG_SYMBOL_TABLE_H
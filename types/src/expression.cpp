@@ -1,95 +1,41 @@
 #include "expression.h"
 
 
-Expression::Expression()
-        : Object(object_type::ExpressionT) {
-}
-
-Expression::Expression(std::list<sptrObj> &&data)
+Expression::Expression(expr::operation operation, std::vector<sptrObj> &&operands)
         : Object(object_type::ExpressionT),
-          args_(std::move(data)) {
-}
-
-int Expression::Priority(const std::shared_ptr<Object> &sptr) {
-    if (IsSymbolEqual(sptr, "+") || IsSymbolEqual(sptr, "-")) {
-        return 1;
-    }
-    if (IsSymbolEqual(sptr, "*") || IsSymbolEqual(sptr, "/")) {
-        return 2;
-    }
-    return 0;
-}
-
-bool Expression::IsOperation(const std::shared_ptr<Object> &sptr) {
-    if (!Is<Symbol>(sptr)) {
-        return false;
-    }
-    std::string value = As<Symbol>(sptr)->GetString();
-    return value == "+" || value == "-" || value == "*" || value == "/";
-}
-
-bool Expression::IsSymbolEqual(const std::shared_ptr<Object> &sptr, std::string_view sv) {
-    return Is<Symbol>(sptr) && As<Symbol>(sptr)->GetString() == sv;
+          operation_(operation),
+          operands_(std::move(operands)) {
 }
 
 std::string Expression::GetString() {
-    return "<expression object>";
-}
-
-size_t Expression::GetSize() const {
-    return args_.size();
-}
-
-void Expression::AddArg(sptrObj &&arg) {
-    args_.push_back(std::move(arg));
+    if (operation_ == expr::Neg) {
+        return "-(" + operands_.front()->GetString() + ")";
+    }
+    return "(" + operands_.front()->GetString() + " " + std::string(OperationName(operation_)) + " " +
+           operands_.back()->GetString() + ")";
 }
 
-std::list<sptrObj> &Expression::GetArgs() {
-    return args_;
+expr::operation Expression::GetOperation() const {
+    return operation_;
 }
 
-void Expression::FormatInfix() {
-    if (IsSymbolEqual(args_.front(), "+") || IsSymbolEqual(args_.front(), "-")) {
-        args_.push_front(std::make_shared<Rational>(0));
-    }
-    for (auto it = args_.begin(); it != args_.end(); ++it) {
-        auto floating_it = it;
-        if (IsSymbolEqual(*it, "(") && IsOperation(*++floating_it) && Is<Evaluable>(*++floating_it)) {
-            if (IsSymbolEqual(*--floating_it, "+") || IsSymbolEqual(*floating_it, "-")) {
-                args_.insert(floating_it, std::make_shared<Rational>(0));
-            } else {
-                throw RuntimeError("Format: invalid operation was received\n");
-            }
-        }
-    }
+const std::vector<sptrObj> &Expression::GetOperands() const {
+    return operands_;
 }
 
-void Expression::Infix2Postfix() {
-    FormatInfix();
-    std::list<std::shared_ptr<Object>> postfix;
-    std::stack<std::shared_ptr<Object>> s;
-    for (auto &arg: args_) {
-        if (IsSymbolEqual(arg, "(")) { // if opening bracket then push the stack
-            s.push(arg);
-        } else if (IsSymbolEqual(arg, ")")) {       // if closing bracket encounted then keep popping from stack until
-            while (!IsSymbolEqual(s.top(), "(")) {
-                postfix.push_back(s.top());
-                s.pop();
-            }
-            s.pop();
-        } else if (IsOperation(arg)) {
-            while (!s.empty() && Priority(arg) <= Priority(s.top())) {
-                postfix.push_back(s.top());
-                s.pop();
-            }
-            s.push(arg);
-        } else if (Is<Symbol>(arg) || Is<Evaluable>(arg)) {
-            postfix.push_back(arg);
-        }
-    }
-    while (!s.empty()) {
-        postfix.push_back(s.top());
-        s.pop();
+std::string_view Expression::OperationName(expr::operation operation) {
+    switch (operation) {
+        case expr::Add:
+            return "+";
+        case expr::Sub:
+        case expr::Neg:
+            return "-";
+        case expr::Mul:
+            return "*";
+        case expr::Div:
+            return "/";
+        case expr::Pow:
+            return "^";
     }
-    args_ = std::move(postfix);
+    return "";
 }
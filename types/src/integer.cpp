@@ -1,5 +1,7 @@
 #include "integer.h"
 
+#include <charconv>
+
 Integer::Integer(int64_t value)
         : Evaluable(object_type::IntegerT),
           value_(value) {
@@ -22,6 +24,11 @@ std::string Integer::GetString() {
     return std::to_string(value_);
 }
 
+void Integer::AppendString(std::string &out) {
+    char buffer[20]; // -9223372036854775808
+    out.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), value_).ptr);
+}
+
 std::shared_ptr<Evaluable> Integer::operator+(const std::shared_ptr<Evaluable> &other) const {
     if (!Is<Integer>(other)) {
         throw SyntaxError("invalid argument: <integer> + <$invalid$>");
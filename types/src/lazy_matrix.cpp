@@ -0,0 +1,172 @@
+#include "lazy_matrix.h"
+
+
+LazyMatrix::LazyMatrix(std::shared_ptr<Matrix> matrix)
+        : Evaluable(object_type::LazyMatrixT),
+          kind_(Kind::Leaf),
+          leaf_(std::move(matrix)) {
+    std::tie(lines_, columns_) = leaf_->size();
+}
+
+LazyMatrix::LazyMatrix(Kind kind, sptrLazy lhs, sptrLazy rhs)
+        : Evaluable(object_type::LazyMatrixT),
+          kind_(kind),
+          lhs_(std::move(lhs)),
+          rhs_(std::move(rhs)) {
+    if (lhs_->size() != rhs_->size()) {
+        throw RuntimeError("LazyMatrix: matrices sizes are not equal\n");
+    }
+    std::tie(lines_, columns_) = lhs_->size();
+}
+
+LazyMatrix::LazyMatrix(Kind kind, sptrLazy lhs, std::shared_ptr<Evaluable> scalar)
+        : Evaluable(object_type::LazyMatrixT),
+          kind_(kind),
+          lhs_(std::move(lhs)),
+          scalar_(std::move(scalar)) {
+    std::tie(lines_, columns_) = lhs_->size();
+}
+
+LazyMatrix::LazyMatrix(sptrLazy operand)
+        : Evaluable(object_type::LazyMatrixT),
+          kind_(Kind::Transpose),
+          lhs_(std::move(operand)) {
+    std::tie(columns_, lines_) = lhs_->size();
+}
+
+LazyMatrix::LazyMatrix(size_t lines, size_t columns, std::function<std::shared_ptr<Matrix>()> source)
+        : Evaluable(object_type::LazyMatrixT),
+          kind_(Kind::Deferred),
+          source_(std::move(source)),
+          lines_(lines),
+          columns_(columns) {
+}
+
+sptrLazy LazyMatrix::Of(const sptrObj &object) {
+    if (Is<LazyMatrix>(object)) {
+        return As<LazyMatrix>(object);
+    }
+    if (Is<Matrix>(object)) {
+        return std::make_shared<LazyMatrix>(As<Matrix>(object));
+    }
+    throw RuntimeError("LazyMatrix::Of: matrix was expected\n");
+}
+
+sptrLazy LazyMatrix::Self() const {
+    return std::static_pointer_cast<LazyMatrix>(std::const_pointer_cast<Object>(shared_from_this()));
+}
+
+std::pair<size_t, size_t> LazyMatrix::size() const {
+    return {lines_, columns_};
+}
+
+std::shared_ptr<Evaluable> LazyMatrix::operator+(const std::shared_ptr<Evaluable> &rhs) const {
+    if (!IsMatrixLike(rhs)) {
+        throw RuntimeError("LazyMatrix::operator+: invalid operand type\n");
+    }
+    return std::make_shared<LazyMatrix>(Kind::Add, Self(), Of(rhs));
+}
+
+std::shared_ptr<Evaluable> LazyMatrix::operator-(const std::shared_ptr<Evaluable> &rhs) const {
+    if (!IsMatrixLike(rhs)) {
+        throw RuntimeError("LazyMatrix::operator-: invalid operand type\n");
+    }
+    return std::make_shared<LazyMatrix>(Kind::Sub, Self(), Of(rhs));
+}
+
+std::shared_ptr<Evaluable> LazyMatrix::operator*(const std::shared_ptr<Evaluable> &other) const {
+    if (Is<Rational>(other)) {
+        return std::make_shared<LazyMatrix>(Kind::Scale, Self(), other);
+    }
+    if (IsMatrixLike(other)) { // matrix product is not elementwise, so both operands are computed here
+        auto [lhs, lhs_transposed] = MultiplicationOperand();
+        auto [rhs, rhs_transposed] = Of(other)->MultiplicationOperand();
+        return Matrix::Multiply(*lhs, lhs_transposed, *rhs, rhs_transposed);
+    }
+    throw RuntimeError("LazyMatrix::operator*: invalid operand type\n");
+}
+
+std::shared_ptr<Evaluable> LazyMatrix::operator/(const std::shared_ptr<Evaluable> &other) const {
+    if (Is<Rational>(other)) {
+        return std::make_shared<LazyMatrix>(Kind::Divide, Self(), other);
+    }
+    throw RuntimeError("LazyMatrix::operator/: invalid operand type\n");
+}
+
+std::shared_ptr<Evaluable> LazyMatrix::EvalAt(size_t line, size_t column) const {
+    if (materialized_) {
+        return As<Evaluable>((*materialized_)[line][column]);
+    }
+    switch (kind_) {
+        case Kind::Leaf:
+            return As<Evaluable>((*leaf_)[line][column]);
+        case Kind::Add:
+            return *lhs_->EvalAt(line, column) + rhs_->EvalAt(line, column);
+        case Kind::Sub:
+            return *lhs_->EvalAt(line, column) - rhs_->EvalAt(line, column);
+        case Kind::Scale:
+            return *scalar_ * lhs_->EvalAt(line, column);
+        case Kind::Divide:
+            return *lhs_->EvalAt(line, column) / scalar_;
+        case Kind::Transpose:
+            return lhs_->EvalAt(column, line);
+        case Kind::Deferred:
+            return As<Evaluable>((*Materialize())[line][column]);
+    }
+    throw RuntimeError("LazyMatrix::EvalAt: unknown node kind\n");
+}
+
+std::shared_ptr<Matrix> LazyMatrix::Materialize() const {
+    if (kind_ == Kind::Leaf) {
+        return leaf_;
+    }
+    if (kind_ == Kind::Deferred && !materialized_) {
+        materialized_ = source_();
+        source_ = nullptr; // it may hold resources like mapped file
+        if (materialized_->size() != size()) {
+            throw RuntimeError("LazyMatrix::Materialize: deferred matrix has unexpected size\n");
+        }
+    }
+    if (!materialized_) {
+        // fused kernel: every cell goes through the whole chain of operations, no intermediate matrices
+        std::vector<std::vector<sptrObj>> data(lines_);
+        for (size_t curr_l = 0; curr_l < lines_; ++curr_l) {
+            data[curr_l].reserve(columns_);
+            for (size_t curr_c = 0; curr_c < columns_; ++curr_c) {
+                data[curr_l].push_back(EvalAt(curr_l, curr_c));
+            }
+        }
+        materialized_ = std::make_shared<Matrix>(std::move(data));
+        // operands are not needed anymore, intermediate results could be freed
+        lhs_.reset();
+        rhs_.reset();
+        scalar_.reset();
+    }
+    return materialized_;
+}
+
+std::pair<std::shared_ptr<Matrix>, bool> LazyMatrix::MultiplicationOperand() const {
+    if (kind_ == Kind::Transpose && !materialized_) {
+        return {lhs_->Materialize(), true};
+    }
+    return {Materialize(), false};
+}
+
+std::string LazyMatrix::GetString() {
+    return Materialize()->GetString();
+}
+
+void LazyMatrix::AppendString(std::string &out) {
+    Materialize()->AppendString(out);
+}
+
+bool IsMatrixLike(const sptrObj &object) {
+    return Is<Matrix>(object) || Is<LazyMatrix>(object);
+}
+
+sptrObj Materialize(const sptrObj &object) {
+    if (Is<LazyMatrix>(object)) {
+        return As<LazyMatrix>(object)->Materialize();
+    }
+    return object;
+}
@@ -149,24 +149,132 @@ void Matrix::operator-=(const Matrix &rhs) {
 }
 
 void Matrix::operator*=(const Matrix &other) {
-    auto[other_lines, other_columns] = other.size();
-    if (columns_ != other_lines) {
+    *this = std::move(*Multiply(*this, false, other, false));
+}
+
+static void AddProduct(sptrObj &acc, const sptrObj &lhs, const sptrObj &rhs) {
+    acc = *As<Evaluable>(acc) + (*As<Evaluable>(lhs) * As<Evaluable>(rhs));
+}
+
+static sptrObj Dot(const std::vector<sptrObj> &lhs, const std::vector<sptrObj> &rhs) {
+    sptrObj acc = std::make_shared<Rational>(0);
+    for (size_t curr_ind = 0; curr_ind < lhs.size(); ++curr_ind) {
+        AddProduct(acc, lhs[curr_ind], rhs[curr_ind]);
+    }
+    return acc;
+}
+
+static bool IsZero(const sptrObj &value) {
+    return As<Rational>(value)->Numerator() == 0;
+}
+
+std::shared_ptr<Matrix> Matrix::Multiply(const Matrix &lhs, bool lhs_transposed,
+                                         const Matrix &rhs, bool rhs_transposed) {
+    size_t lines = lhs_transposed ? lhs.columns_ : lhs.lines_;
+    size_t inner = lhs_transposed ? lhs.lines_ : lhs.columns_;
+    size_t columns = rhs_transposed ? rhs.lines_ : rhs.columns_;
+    if (inner != (rhs_transposed ? rhs.columns_ : rhs.lines_)) {
         throw SyntaxError("Matrix::operator*=: invalid matrices sizes");
     }
-    std::vector<std::vector<sptrObj>> new_data;
-    new_data.resize(lines_);
-    for (size_t curr_l = 0; curr_l < lines_; ++curr_l) {
-        new_data[curr_l].resize(other_columns);
-        for (size_t curr_c = 0; curr_c < other_columns; ++curr_c) {
-            new_data[curr_l][curr_c] = std::make_shared<Rational>(0);
-            for (size_t curr_ind = 0; curr_ind < columns_; ++curr_ind) {
-                new_data[curr_l][curr_c] = *As<Evaluable>(new_data[curr_l][curr_c]) + As<Evaluable>(
-                        *As<Evaluable>(matrix_[curr_l][curr_ind]) * As<Evaluable>(other.matrix_[curr_ind][curr_c]));
+    if (&lhs == &rhs && lhs_transposed != rhs_transposed) { // A * A^T or A^T * A
+        return MultiplySymmetric(lhs, lhs_transposed);
+    }
+    if (lhs_transposed && rhs_transposed) { // A^T * B^T = (B * A)^T
+        return As<Matrix>(Multiply(rhs, false, lhs, false)->Transposed());
+    }
+    // loops are ordered so that both operands and result are read along lines
+    sptrObj zero = std::make_shared<Rational>(0);
+    std::vector<std::vector<sptrObj>> result(lines, std::vector<sptrObj>(columns, zero));
+    if (!lhs_transposed && !rhs_transposed) { // i-k-j
+        for (size_t curr_l = 0; curr_l < lines; ++curr_l) {
+            std::vector<sptrObj> &result_line = result[curr_l];
+            for (size_t curr_ind = 0; curr_ind < inner; ++curr_ind) {
+                const sptrObj &value = lhs.matrix_[curr_l][curr_ind];
+                if (IsZero(value)) {
+                    continue;
+                }
+                const std::vector<sptrObj> &rhs_line = rhs.matrix_[curr_ind];
+                for (size_t curr_c = 0; curr_c < columns; ++curr_c) {
+                    AddProduct(result_line[curr_c], value, rhs_line[curr_c]);
+                }
+            }
+        }
+    } else if (lhs_transposed) { // k-i-j: lines of A are columns of A^T
+        for (size_t curr_ind = 0; curr_ind < inner; ++curr_ind) {
+            const std::vector<sptrObj> &lhs_line = lhs.matrix_[curr_ind];
+            const std::vector<sptrObj> &rhs_line = rhs.matrix_[curr_ind];
+            for (size_t curr_l = 0; curr_l < lines; ++curr_l) {
+                if (IsZero(lhs_line[curr_l])) {
+                    continue;
+                }
+                for (size_t curr_c = 0; curr_c < columns; ++curr_c) {
+                    AddProduct(result[curr_l][curr_c], lhs_line[curr_l], rhs_line[curr_c]);
+                }
+            }
+        }
+    } else { // i-j-k: every cell is a dot product of two lines
+        for (size_t curr_l = 0; curr_l < lines; ++curr_l) {
+            for (size_t curr_c = 0; curr_c < columns; ++curr_c) {
+                result[curr_l][curr_c] = Dot(lhs.matrix_[curr_l], rhs.matrix_[curr_c]);
+            }
+        }
+    }
+    return std::make_shared<Matrix>(std::move(result));
+}
+
+std::shared_ptr<Matrix> Matrix::Power(const Matrix &matrix, uint64_t exponent) {
+    if (matrix.lines_ != matrix.columns_) {
+        throw RuntimeError("Matrix::Power: matrix must be square\n");
+    }
+    std::shared_ptr<Matrix> result = std::make_shared<Matrix>(matrix.lines_, matrix.columns_);
+    for (size_t i = 0; i < result->lines_; ++i) {
+        for (size_t j = 0; j < result->columns_; ++j) {
+            result->matrix_[i][j] = std::make_shared<Rational>(i == j ? 1 : 0);
+        }
+    }
+    std::shared_ptr<Matrix> base;
+    for (; exponent; exponent >>= 1) {
+        const Matrix &curr_base = base ? *base : matrix;
+        if (exponent & 1) {
+            result = Multiply(*result, false, curr_base, false);
+        }
+        if (exponent > 1) {
+            base = Multiply(curr_base, false, curr_base, false);
+        }
+    }
+    return result;
+}
+
+std::shared_ptr<Matrix> Matrix::MultiplySymmetric(const Matrix &matrix, bool first_transposed) {
+    // Gram matrix is symmetric, so only upper triangle is computed and then mirrored
+    size_t size = first_transposed ? matrix.columns_ : matrix.lines_;
+    sptrObj zero = std::make_shared<Rational>(0);
+    std::vector<std::vector<sptrObj>> result(size, std::vector<sptrObj>(size, zero));
+    if (!first_transposed) { // A * A^T
+        for (size_t curr_l = 0; curr_l < size; ++curr_l) {
+            for (size_t curr_c = curr_l; curr_c < size; ++curr_c) {
+                result[curr_l][curr_c] = Dot(matrix.matrix_[curr_l], matrix.matrix_[curr_c]);
             }
         }
+    } else { // A^T * A
+        for (size_t curr_ind = 0; curr_ind < matrix.lines_; ++curr_ind) {
+            const std::vector<sptrObj> &line = matrix.matrix_[curr_ind];
+            for (size_t curr_l = 0; curr_l < size; ++curr_l) {
+                if (IsZero(line[curr_l])) {
+                    continue;
+                }
+                for (size_t curr_c = curr_l; curr_c < size; ++curr_c) {
+                    AddProduct(result[curr_l][curr_c], line[curr_l], line[curr_c]);
+                }
+            }
+        }
+    }
+    for (size_t curr_l = 1; curr_l < size; ++curr_l) {
+        for (size_t curr_c = 0; curr_c < curr_l; ++curr_c) {
+            result[curr_l][curr_c] = result[curr_c][curr_l];
+        }
     }
-    matrix_ = std::move(new_data);
-    columns_ = other_columns;
+    return std::make_shared<Matrix>(std::move(result));
 }
 
 std::shared_ptr<Evaluable> Matrix::operator+(const std::shared_ptr<Evaluable> &rhs) const {
@@ -214,7 +322,7 @@ void Matrix::operator/=(const Ty &scalar) requires std::is_base_of_v<Evaluable,
     for (size_t curr_l = 0; curr_l < lines_; ++curr_l) {
         for (size_t curr_c = 0; curr_c < columns_; ++curr_c) {
             matrix_[curr_l][curr_c] =
-                    scalar / As<Evaluable>(matrix_[curr_l][curr_c]); // can be extended to Rational
+                    *As<Evaluable>(matrix_[curr_l][curr_c]) / std::make_shared<Ty>(scalar);
         }
     }
 }
@@ -247,6 +355,32 @@ std::vector<std::vector<sptrObj>> &Matrix::GetArray() {
     return matrix_;
 }
 
+const std::vector<std::vector<sptrObj>> &Matrix::GetArray() const {
+    return matrix_;
+}
+
+void Matrix::AppendLines(std::string &out, size_t begin, size_t end) {
+    if (begin == 0) {
+        out += '[';
+    }
+    for (size_t curr_l = begin; curr_l < end; ++curr_l) {
+        size_t line_begin = out.size();
+        out += curr_l != 0 ? "],\n [" : "[";
+        for (size_t curr_c = 0; curr_c < columns_; ++curr_c) {
+            if (curr_c != 0) {
+                out += ",\t";
+            }
+            matrix_[curr_l][curr_c]->AppendString(out);
+        }
+        if (curr_l == begin && end - begin > 1) { // the rest of lines are expected to be about as long
+            out.reserve(out.size() + (out.size() - line_begin) * (end - begin));
+        }
+    }
+    if (end == lines_) {
+        out += "]]";
+    }
+}
+
 std::ostream &Matrix::PrintOut(std::ostream &out) const {
     for (size_t curr_l = 0; curr_l < lines_; ++curr_l) {
         if (curr_l != 0) {
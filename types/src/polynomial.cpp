@@ -0,0 +1,88 @@
+#include "polynomial.h"
+
+
+Polynomial::Polynomial()
+        : Object(object_type::PolynomialT),
+          coefficients_{std::make_shared<Rational>(0)} {
+}
+
+Polynomial::Polynomial(std::vector<std::shared_ptr<Evaluable>> &&coefficients)
+        : Object(object_type::PolynomialT),
+          coefficients_(std::move(coefficients)) {
+    if (coefficients_.empty()) {
+        coefficients_.push_back(std::make_shared<Rational>(0));
+    }
+    Normalize();
+}
+
+void Polynomial::Normalize() {
+    while (coefficients_.size() > 1 && As<Rational>(coefficients_.back())->Numerator() == 0) {
+        coefficients_.pop_back();
+    }
+}
+
+size_t Polynomial::Degree() const {
+    return coefficients_.size() - 1;
+}
+
+const std::vector<std::shared_ptr<Evaluable>> &Polynomial::Coefficients() const {
+    return coefficients_;
+}
+
+std::shared_ptr<Evaluable> Polynomial::Evaluate(const std::shared_ptr<Evaluable> &point) const {
+    std::shared_ptr<Evaluable> value = coefficients_.back();
+    for (size_t k = coefficients_.size() - 1; k-- > 0;) {
+        value = *(*value * point) + coefficients_[k];
+    }
+    return value;
+}
+
+std::shared_ptr<Polynomial> Polynomial::MultiplyByLinear(const std::shared_ptr<Evaluable> &root) const {
+    std::vector<std::shared_ptr<Evaluable>> result(coefficients_.size() + 1);
+    result[coefficients_.size()] = coefficients_.back();
+    for (size_t k = coefficients_.size() - 1; k > 0; --k) {
+        result[k] = *coefficients_[k - 1] - (*coefficients_[k] * root);
+    }
+    result[0] = *std::make_shared<Rational>(0) - (*coefficients_[0] * root);
+    return std::make_shared<Polynomial>(std::move(result));
+}
+
+std::shared_ptr<Polynomial> Polynomial::SubtractScaled(const Polynomial &other,
+                                                       const std::shared_ptr<Evaluable> &scalar) const {
+    std::vector<std::shared_ptr<Evaluable>> result = coefficients_;
+    if (result.size() < other.coefficients_.size()) {
+        result.resize(other.coefficients_.size(), std::make_shared<Rational>(0));
+    }
+    for (size_t k = 0; k < other.coefficients_.size(); ++k) {
+        result[k] = *result[k] - (*other.coefficients_[k] * scalar);
+    }
+    return std::make_shared<Polynomial>(std::move(result));
+}
+
+std::string Polynomial::GetString() {
+    // x^3 - 6*x^2 + 11/2*x - 3
+    std::string result;
+    for (size_t k = coefficients_.size(); k-- > 0;) {
+        std::shared_ptr<Rational> coefficient = As<Rational>(coefficients_[k]);
+        if (coefficient->Numerator() == 0 && !(k == 0 && result.empty())) {
+            continue;
+        }
+        bool negative = coefficient->Numerator() < 0;
+        if (result.empty()) {
+            result += negative ? "-" : "";
+        } else {
+            result += negative ? " - " : " + ";
+        }
+        Rational abs_value(negative ? -coefficient->Numerator() : coefficient->Numerator(),
+                           coefficient->Denominator());
+        if (k == 0 || abs_value.Numerator() != 1 || abs_value.Denominator() != 1) {
+            result += abs_value.GetString() + (k == 0 ? "" : "*");
+        }
+        if (k == 1) {
+            result += "x";
+        } else if (k > 1) {
+            result += "x^" + std::to_string(k);
+        }
+    }
+    return result;
+}
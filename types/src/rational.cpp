@@ -1,5 +1,8 @@
 #include "rational.h"
 
+#include <bit>
+#include <charconv>
+
 int64_t GCD(int64_t a, int64_t b) {
     if (b == 0) {
         return a;
@@ -36,7 +39,7 @@ Rational::Rational(int64_t num)
           denominator_(std::make_shared<Integer>(1)) {}
 
 Rational::Rational(int64_t num, int64_t denom)
-        : Evaluable(object_type::IntegerT),
+        : Evaluable(object_type::RationalT),
           numerator_(std::make_shared<Integer>(num)),
           denominator_(std::make_shared<Integer>(denom)) {
     if (denom == 0) {
@@ -91,10 +94,19 @@ std::shared_ptr<Evaluable> Rational::operator/(const std::shared_ptr<Evaluable>
 }
 
 std::string Rational::GetString() {
-    if (Denominator() == 1) {
-        return numerator_->GetString();
+    std::string result;
+    AppendString(result);
+    return result;
+}
+
+void Rational::AppendString(std::string &out) {
+    char buffer[41]; // -9223372036854775808/9223372036854775807
+    char *end = std::to_chars(buffer, buffer + sizeof(buffer), Numerator()).ptr;
+    if (Denominator() != 1) {
+        *end++ = '/';
+        end = std::to_chars(end, buffer + sizeof(buffer), Denominator()).ptr;
     }
-    return numerator_->GetString() + "/" + denominator_->GetString();
+    out.append(buffer, end);
 }
 
 int64_t Rational::Numerator() const {
@@ -108,6 +120,12 @@ int64_t Rational::Denominator() const {
     return denominator_->GetValue();
 }
 
+size_t Rational::BitSize() const {
+    int64_t numerator = Numerator();
+    uint64_t abs_numerator = numerator < 0 ? 0 - static_cast<uint64_t>(numerator) : numerator;
+    return std::bit_width(abs_numerator) + std::bit_width(static_cast<uint64_t>(Denominator()));
+}
+
 std::shared_ptr<Evaluable> Rational::operator+() const {
     return std::make_shared<Rational>(Numerator(), Denominator());
 }
@@ -0,0 +1,43 @@
+#include "symbol_table.h"
+
+#include <mutex>
+
+
+SymbolTable &SymbolTable::Instance() {
+    static SymbolTable instance;
+    return instance;
+}
+
+uint32_t SymbolTable::Intern(std::string_view name) {
+    {
+        std::shared_lock lock(mutex_);
+        if (auto it = ids_.find(name); it != ids_.end()) {
+            return it->second;
+        }
+    }
+    std::unique_lock lock(mutex_);
+    if (auto it = ids_.find(name); it != ids_.end()) { // interned while lock was released
+        return it->second;
+    }
+    uint32_t id = names_.size();
+    ids_.emplace(names_.emplace_back(name), id); // key views the stored copy, not the argument
+    return id;
+}
+
+std::optional<uint32_t> SymbolTable::Find(std::string_view name) const {
+    std::shared_lock lock(mutex_);
+    if (auto it = ids_.find(name); it != ids_.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+const std::string &SymbolTable::Name(uint32_t id) const {
+    std::shared_lock lock(mutex_);
+    return names_[id];
+}
+
+size_t SymbolTable::Size() const {
+    std::shared_lock lock(mutex_);
+    return names_.size();
+}